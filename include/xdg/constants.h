@@ -114,6 +114,15 @@ struct Property{
 
 static Property VOID_MATERIAL {PropertyType::MATERIAL, "void"};
 
+// boundary condition of surfaces without one assigned
+static Property TRANSMISSION_BOUNDARY {PropertyType::BOUNDARY_CONDITION, "transmission"};
+
+// Interned property value identifier
+using PropertyID = int32_t;
+
+// Null property ID
+constexpr PropertyID PROPERTY_NONE {-1};
+
 // Enumerator for different ray fire types
 enum class RayFireType { VOLUME, POINT_CONTAINMENT, ACCUMULATE_HITS, FIND_VOLUME };
 
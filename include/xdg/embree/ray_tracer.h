@@ -12,10 +12,17 @@
 #include "xdg/geometry_data.h"
 #include "xdg/ray_tracing_interface.h"
 #include "xdg/ray.h"
+#include "xdg/tetrahedron_contain.h"
 #include "xdg/error.h"
 
 namespace xdg {
 
+// Representation of mesh surfaces within Embree scenes
+enum class EmbreeSurfaceMode {
+  USER,    // user-defined geometries with double precision callbacks
+  TRIANGLE // native single precision triangle geometries, hits refined in double precision
+};
+
 class EmbreeRayTracer : public RayTracer {
   // constructors
 public:
@@ -23,11 +30,18 @@ public:
   ~EmbreeRayTracer();
   RTLibrary library() const override { return RTLibrary::EMBREE; }
 
+  bool concurrent_queries() const override { return true; }
+
+  uint64_t tree_build_key() const override;
+
   void init() override;
   RTCScene create_embree_scene();
 
   std::pair<TreeID, TreeID> register_volume(const std::shared_ptr<MeshManager>& mesh_manager, MeshID volume) override;
 
+  std::vector<std::pair<TreeID, TreeID>> register_volumes(const std::shared_ptr<MeshManager>& mesh_manager,
+                                                          const std::vector<MeshID>& volumes) override;
+
   TreeID create_surface_tree(const std::shared_ptr<MeshManager>& mesh_manager, MeshID volume) override;
 
   TreeID create_element_tree(const std::shared_ptr<MeshManager>& mesh_manager, MeshID volume) override;
@@ -36,10 +50,23 @@ public:
 
   void create_global_element_tree() override;
 
+  void create_global_trees() override;
+
   MeshID find_element(const Position& point) const override;
 
   MeshID find_element(TreeID tree, const Position& point) const override;
 
+  size_t find_element_batch(size_t n_points,
+                            const Position* points,
+                            MeshID* elements,
+                            bool* missed = nullptr) const override;
+
+  size_t find_element_batch(TreeID tree,
+                            size_t n_points,
+                            const Position* points,
+                            MeshID* elements,
+                            bool* missed = nullptr) const override;
+
 
   // Query Methods
   bool point_in_volume(TreeID scene,
@@ -55,6 +82,41 @@ public:
                                      HitOrientation orientation = HitOrientation::EXITING,
                                      std::vector<MeshID>* const exclude_primitives = nullptr) override;
 
+  bool point_in_volume_with_history(TreeID scene,
+                                    const Position& point,
+                                    const Direction* direction,
+                                    const RayHistory* history) const override;
+
+  std::pair<double, MeshID> ray_fire_with_history(TreeID scene,
+                                                  const Position& origin,
+                                                  const Direction& direction,
+                                                  const double dist_limit,
+                                                  HitOrientation orientation,
+                                                  RayHistory* history) override;
+
+  void point_in_volume_batch(TreeID scene,
+                             size_t n_points,
+                             const Position* points,
+                             const Direction* directions,
+                             PointInVolume* results) const override;
+
+  void find_volume_by_ray_batch(TreeID tree,
+                                const MeshManager& mesh_manager,
+                                size_t n_points,
+                                const Position* points,
+                                const Direction* directions,
+                                MeshID* volumes,
+                                bool* resolved) override;
+
+  void ray_fire_batch(size_t n_rays,
+                      const TreeID* trees,
+                      const Position* origins,
+                      const Direction* directions,
+                      const double* dist_limits,
+                      double* distances,
+                      MeshID* surfaces,
+                      HitOrientation orientation = HitOrientation::EXITING) override;
+
   std::pair<double, MeshID> closest(TreeID scene,
                                     const Position& origin) override;
 
@@ -63,6 +125,67 @@ public:
                 const Direction& direction,
                 double& dist) const override;
 
+  /**
+   * @brief Set how surfaces are represented in Embree scenes.
+   *
+   * In USER mode (the default) every triangle is tested in double precision
+   * by user geometry callbacks. In TRIANGLE mode Embree's native triangle
+   * kernels are used for traversal and each hit reported by Embree is
+   * verified and refined in double precision by a filter function. Must be
+   * called before any surface trees are created.
+   */
+  void set_surface_mode(EmbreeSurfaceMode mode);
+
+  EmbreeSurfaceMode surface_mode() const { return surface_mode_; }
+
+  // Triangle vertex cache
+
+  /**
+   * @brief Enable or disable the packed triangle vertex cache.
+   *
+   * When enabled, the vertices of each surface triangle are copied into a
+   * contiguous buffer (in primitive order) when a surface tree is created so
+   * that the Embree callbacks can read them directly rather than querying the
+   * mesh manager. Only affects trees created after this call.
+   */
+  void set_cache_triangle_vertices(bool cache) { cache_triangle_vertices_ = cache; }
+
+  bool cache_triangle_vertices() const { return cache_triangle_vertices_; }
+
+  //! Size in bytes of the triangle vertex cache across all surface trees
+  size_t triangle_vertex_cache_size() const;
+
+  /**
+   * @brief Enable or disable use of the face plane cache.
+   *
+   * When enabled, surface trees read the normal and plane offset of each
+   * triangle from the mesh manager's face plane cache (if it has been built,
+   * see MeshManager::build_face_planes), so the Embree callbacks do not
+   * recompute a normal for every candidate hit. Only affects trees created
+   * after this call.
+   */
+  void set_cache_face_planes(bool cache) { cache_face_planes_ = cache; }
+
+  bool cache_face_planes() const { return cache_face_planes_; }
+
+  // Tetrahedron transform cache
+
+  /**
+   * @brief Enable or disable the tetrahedron transform cache.
+   *
+   * When enabled, the barycentric transform of each volume element is
+   * computed when an element tree is created and stored in primitive order,
+   * so point location tests containment with one matrix-vector product
+   * instead of reading the element's vertices and inverting a matrix for
+   * every candidate. Only affects trees created after this call.
+   */
+  void set_cache_tet_transforms(bool cache) { cache_tet_transforms_ = cache; }
+
+  bool cache_tet_transforms() const { return cache_tet_transforms_; }
+
+  //! Size in bytes of the tetrahedron transform cache across all element trees
+  size_t tet_transform_cache_size() const;
+
   // Embree members
   RTCDevice device_;
   std::vector<RTCGeometry> geometries_; //<! All geometries created by this ray tracer
@@ -79,16 +202,54 @@ public:
 
   // storage
   std::unordered_map<RTCScene, std::vector<PrimitiveRef>> primitive_ref_storage_;
+  std::unordered_map<RTCScene, std::vector<std::array<Vertex, 3>>> vertex_storage_; //<! Cached triangle vertices, parallel to primitive_ref_storage_
+  std::unordered_map<RTCScene, std::vector<BoundingBox>> bounds_storage_; //<! Element bounding boxes, parallel to primitive_ref_storage_
+  std::unordered_map<RTCScene, std::vector<TetTransform>> transform_storage_; //<! Cached element transforms, parallel to primitive_ref_storage_
 
 private:
   std::pair<RTCGeometry, std::shared_ptr<SurfaceUserData>> register_surface(const std::shared_ptr<MeshManager>& mesh_manager,
                                                                              MeshID surface,
                                                                              RTCScene& volume_scene,
                                                                              int& storage_offset);
+
+  //! Create the scene of a volume's surface tree without committing it
+  SurfaceTreeID create_surface_scene(const std::shared_ptr<MeshManager>& mesh_manager, MeshID volume);
+
+  //! Create the scene of a volume's element tree without committing it
+  ElementTreeID create_element_scene(const std::shared_ptr<MeshManager>& mesh_manager, MeshID volume);
+
+  //! Create the global surface scene without committing it
+  void create_global_surface_scene();
+
+  //! Create the global element scene without committing it
+  void create_global_element_scene();
+
+  //! Commit (build) a set of independent scenes concurrently
+  void commit_scenes(const std::vector<RTCScene>& scenes);
+
+  //! Locate the element containing a point in an element scene
+  MeshID locate_element(RTCScene scene, const Position& point) const;
+
+  //! Fire a ray against a surface scene, dispatching on the surface mode
+  void intersect(RTCScene scene, RTCDualRayHit& rayhit) const;
+
+  //! Fire a ray against a surface tree, culling any excluded primitives
+  RTCDualRayHit fire_surface_ray(TreeID tree,
+                                 const Position& origin,
+                                 const Direction& direction,
+                                 double dist_limit,
+                                 HitOrientation orientation,
+                                 const std::vector<MeshID>* exclude_primitives,
+                                 const RayHistory* history) const;
+
   // Global Tree IDs
   RTCScene global_surface_scene_ {nullptr};
   RTCScene global_element_scene_ {nullptr};
 
+  EmbreeSurfaceMode surface_mode_ {EmbreeSurfaceMode::USER}; //<! Representation of surfaces in Embree scenes
+  bool cache_triangle_vertices_ {true}; //<! Whether to build the triangle vertex cache for surface trees
+  bool cache_face_planes_ {true}; //<! Whether surface trees read the mesh manager's face plane cache
+  bool cache_tet_transforms_ {true}; //<! Whether to build the tetrahedron transform cache for element trees
 };
 
 } // namespace xdg
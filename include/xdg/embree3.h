@@ -22,4 +22,19 @@ inline void rtcOccluded1(RTCScene scene, RTCRay* ray) {
   }
 }
 
+// embree v4 renamed the intersection context to a ray query context
+using RTCRayQueryContext = RTCIntersectContext;
+
+inline void rtcInitRayQueryContext(RTCRayQueryContext* context) {
+  rtcInitIntersectContext(context);
+}
+
+inline void rtcIntersect1(RTCScene scene, RTCRayHit* rayhit, RTCRayQueryContext* context) {
+  rtcIntersect1(scene, context, rayhit);
+}
+
+inline void rtcOccluded1(RTCScene scene, RTCRay* ray, RTCRayQueryContext* context) {
+  rtcOccluded1(scene, context, ray);
+}
+
 #endif // include guard
\ No newline at end of file
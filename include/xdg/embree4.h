@@ -1,3 +1,23 @@
-
 #include "embree4/rtcore.h"
-#include "embree4/rtcore_ray.h"
\ No newline at end of file
+#include "embree4/rtcore_ray.h"
+
+#ifndef DD_EMBREE_WRAPPERS
+#define DD_EMBREE_WRAPPERS
+
+// provide signatures that accept a ray query context directly, matching the
+// wrappers provided for embree v3
+inline void rtcIntersect1(RTCScene scene, RTCRayHit* rayhit, RTCRayQueryContext* context) {
+  RTCIntersectArguments args;
+  rtcInitIntersectArguments(&args);
+  args.context = context;
+  rtcIntersect1(scene, rayhit, &args);
+}
+
+inline void rtcOccluded1(RTCScene scene, RTCRay* ray, RTCRayQueryContext* context) {
+  RTCOccludedArguments args;
+  rtcInitOccludedArguments(&args);
+  args.context = context;
+  rtcOccluded1(scene, ray, &args);
+}
+
+#endif // include guard
@@ -2,6 +2,7 @@
 #define XDG_GEOMETRY_TRIANGLE_INTERSECT_H
 
 #include <array>
+#include "xdg/constants.h"
 #include "xdg/vec3da.h"
 
 namespace xdg {
@@ -12,6 +13,24 @@ inline Direction triangle_normal(const std::array<Vertex, 3>& vertices) {
   return (v1.cross(v2)).normalize();
 }
 
+//! Plane of a triangle: points p on the plane satisfy normal.dot(p) == offset
+struct FacePlane {
+  Direction normal;
+  double offset;
+};
+
+inline FacePlane triangle_plane(const std::array<Vertex, 3>& vertices) {
+  Direction normal = triangle_normal(vertices);
+  return {normal, normal.dot(vertices[0])};
+}
+
+//! Distance along a ray to a plane (INFTY if the ray is parallel to the plane)
+inline double plane_distance(const FacePlane& plane, const Position& origin, const Direction& direction) {
+  double denom = plane.normal.dot(direction);
+  if (denom == 0.0) return INFTY;
+  return (plane.offset - plane.normal.dot(origin)) / denom;
+}
+
 } // namespace xdg
 
 #endif // XDG_GEOMETRY_TRIANGLE_INTERSECT_H
\ No newline at end of file
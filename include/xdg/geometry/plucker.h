@@ -61,6 +61,50 @@ inline double plucker_edge_test(dp::vec3 vertexa, dp::vec3 vertexb,
   return pip;
 }
 
+/* Distance along a ray to its intersection with a triangle given the Plucker
+  coordinates of the ray with respect to the triangle edges v0->v1, v1->v2 and
+  v2->v0, which must not all be zero. Returns -1 if the intersection lies
+  outside of the triangle.
+*/
+inline double plucker_intersection_distance(dp::vec3 vertices[3],
+                                            dp::vec3 origin,
+                                            dp::vec3 direction,
+                                            double plucker_coord0,
+                                            double plucker_coord1,
+                                            double plucker_coord2)
+{
+  // get the distance to intersection
+  const double inverse_sum =
+    1.0 / (plucker_coord0 + plucker_coord1 + plucker_coord2);
+
+  const dp::vec3 intersection = dp::vec3(plucker_coord0 * inverse_sum * vertices[2] +
+                                         plucker_coord1 * inverse_sum * vertices[0] +
+                                         plucker_coord2 * inverse_sum * vertices[1]);
+
+  // To minimize numerical error, get index of largest magnitude direction.
+  int idx = 0;
+  double max_abs_dir = 0;
+  for (uint i = 0; i < 3; ++i) {
+    if (dp::abs(direction[i]) > max_abs_dir) {
+      idx = i;
+      max_abs_dir = dp::abs(direction[i]);
+    }
+  }
+
+  double dist_out = (intersection[idx] - origin[idx]) / direction[idx];
+
+  // Barycentric coords check
+  double u = plucker_coord2 * inverse_sum;
+  double v = plucker_coord0 * inverse_sum;
+
+  // Barycentric coords check
+  if (u < 0.0 || v < 0.0 || (u + v) > 1.0) {
+      dist_out = -1.0;
+  }
+
+  return dist_out;
+}
+
 inline PluckerIntersectionResult plucker_ray_tri_intersect(dp::vec3 vertices[3],
                                 dp::vec3 origin,
                                 dp::vec3 direction,
@@ -69,8 +113,6 @@ inline PluckerIntersectionResult plucker_ray_tri_intersect(dp::vec3 vertices[3],
                                 bool useOrientation,
                                 int orientation)
 {
-  double dist_out = dp::INFTY;
-
   const dp::vec3 raya = direction;
   const dp::vec3 rayb = dp::cross(direction, origin);
 
@@ -125,34 +167,8 @@ inline PluckerIntersectionResult plucker_ray_tri_intersect(dp::vec3 vertices[3],
     return EXIT_EARLY;
   }
 
-  // get the distance to intersection
-  const double inverse_sum =
-    1.0 / (plucker_coord0 + plucker_coord1 + plucker_coord2);
-
-  const dp::vec3 intersection = dp::vec3(plucker_coord0 * inverse_sum * vertices[2] +
-                                         plucker_coord1 * inverse_sum * vertices[0] +
-                                         plucker_coord2 * inverse_sum * vertices[1]);
-
-  // To minimize numerical error, get index of largest magnitude direction.
-  int idx = 0;
-  double max_abs_dir = 0;
-  for (uint i = 0; i < 3; ++i) {
-    if (dp::abs(direction[i]) > max_abs_dir) {
-      idx = i;
-      max_abs_dir = dp::abs(direction[i]);
-    }
-  }
-
-  dist_out = (intersection[idx] - origin[idx]) / direction[idx];
-
-  // Barycentric coords check
-  double u = plucker_coord2 * inverse_sum;
-  double v = plucker_coord0 * inverse_sum;
-
-  // Barycentric coords check
-  if (u < 0.0 || v < 0.0 || (u + v) > 1.0) {
-      dist_out = -1.0;
-  }
+  double dist_out = plucker_intersection_distance(vertices, origin, direction,
+                                                  plucker_coord0, plucker_coord1, plucker_coord2);
 
   // is the intersection within distance limits?
   if (dist_out < tMin || dist_out > tMax) return EXIT_EARLY;
@@ -1,18 +1,26 @@
 #ifndef _XDG_GEOMETRY_DATA_H
 #define _XDG_GEOMETRY_DATA_H
 
+#include <array>
+
+#include "xdg/bbox.h"
 #include "xdg/constants.h"
+#include "xdg/geometry/face_common.h"
+#include "xdg/vec3da.h"
 
 namespace xdg
 {
 
 struct MeshManager; // Forward declaration
 struct PrimitiveRef; // Forward declaration
+struct TetTransform; // Forward declaration
 
 struct SurfaceUserData {
   MeshID surface_id {ID_NONE}; //! ID of the surface this geometry data is associated with
   MeshManager* mesh_manager {nullptr}; //! Pointer to the mesh manager for this geometry
   PrimitiveRef* prim_ref_buffer {nullptr}; //! Pointer to the mesh primitives in the geometry
+  const std::array<Vertex, 3>* vertex_buffer {nullptr}; //! Pointer to cached primitive vertices (nullptr if not cached)
+  const FacePlane* plane_buffer {nullptr}; //! Pointer to cached primitive planes (nullptr if not cached)
   double box_bump; //! Bump distance for the bounding boxes in this geometry
   MeshID forward_vol {ID_NONE}; // ID of the forward sense volume
   MeshID reverse_vol {ID_NONE}; // ID of the reverse sense volume
@@ -22,6 +30,8 @@ struct VolumeElementsUserData {
   MeshID volume_id {ID_NONE}; //! ID of the volume this geometry data is associated with
   MeshManager* mesh_manager {nullptr}; //! Pointer to the mesh manager for this geometry
   PrimitiveRef* prim_ref_buffer {nullptr}; //! Pointer to the mesh primitives in the geometry
+  const BoundingBox* bounds_buffer {nullptr}; //! Pointer to precomputed primitive bounding boxes (nullptr if not computed)
+  const TetTransform* transform_buffer {nullptr}; //! Pointer to cached primitive barycentric transforms (nullptr if not cached)
 };
 
 } // namespace xdg
@@ -70,7 +70,7 @@ public:
     //! \return The index corresponding to the ID, or INDEX_NONE if not found
     Index id_to_index(ID id) const
     {
-      if (blocks_.empty())
+      if (blocks_.empty() || id < blocks_.front().id_start)
           return INDEX_NONE;
 
       auto it = blocks_.begin();
@@ -3,6 +3,7 @@
 #define _XDG_MESH_MANAGER_INTERFACE
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -11,7 +12,11 @@
 
 #include "xdg/bbox.h"
 #include "xdg/constants.h"
+#include "xdg/geometry/face_common.h"
 #include "xdg/id_block_map.h"
+#include "xdg/property_table.h"
+#include "xdg/tet_mesh.h"
+#include "xdg/topology_table.h"
 #include "xdg/vec3da.h"
 
 namespace xdg {
@@ -60,6 +65,65 @@ public:
                 const Direction& u,
                 double distance) const;
 
+  //! \brief Walk through elements along a ray, passing each segment to a
+  //! visitor as it is found rather than collecting the segments
+  //! \note It is assumed that the provided position is within the starting element.
+  //! \param starting_element The initial element to start the walk from
+  //! \param start The starting position of the ray
+  //! \param u The normalized direction vector of the ray
+  //! \param distance The total distance to travel along the ray
+  //! \param visitor Callable invoked as visitor(element, length) for each
+  //! element traversed. The walk stops early if it returns false.
+  //! \return The distance traveled through the visited elements
+  template<typename Visitor>
+  double walk_elements(MeshID starting_element,
+                       const Position& start,
+                       const Direction& u,
+                       double distance,
+                       Visitor&& visitor) const;
+
+  //! \brief Copy the volume elements into a flat tetrahedral mesh used by
+  //! walk_elements and next_element. Meshes containing elements other than
+  //! tetrahedra continue to be walked through the mesh library.
+  void build_tet_mesh();
+
+  //! \brief Flat tetrahedral mesh used to walk elements (nullptr if not built)
+  std::shared_ptr<const TetMesh> tet_mesh() const { return tet_mesh_; }
+
+  //! \brief Compute the normal and plane offset of every surface face (and
+  //! every face of the flat tetrahedral mesh, if built) once so that
+  //! face_normal, face_plane, surface trees and element walks read them
+  //! instead of recomputing them from the face vertices. Each plane is
+  //! stored once: element faces shared by two elements or lying on a
+  //! surface use the same entry. Does nothing if the cache is already built.
+  void build_face_planes();
+
+  //! \brief Whether the face plane cache has been built
+  bool has_face_planes() const { return !face_planes_.empty(); }
+
+  //! \brief Cached planes of the faces of a surface, in the order returned
+  //! by get_surface_faces (nullptr if the face plane cache has not been built)
+  const FacePlane* surface_face_planes(MeshID surface) const;
+
+  //! \brief Size in bytes of the face plane cache
+  size_t face_plane_cache_size() const { return face_planes_.size() * sizeof(FacePlane); }
+
+  //! \brief Build a dense table of the volume containing each volume element
+  //! so that element_parent_volume is answered without searching the volumes.
+  void build_volume_tables();
+
+  //! \brief Whether the volume tables have been built
+  bool has_volume_tables() const { return !element_volumes_.empty(); }
+
+  //! \brief Volume containing a volume element (the volume tables must have been built)
+  //! \param element The element ID
+  //! \return The volume ID, or ID_NONE if the element is not in any volume
+  MeshID element_parent_volume(MeshID element) const
+  {
+    MeshIndex idx = element_index(element);
+    return idx == INDEX_NONE || idx >= static_cast<MeshIndex>(element_volumes_.size()) ? ID_NONE : element_volumes_[idx];
+  }
+
   //! \brief Find the next element along a ray from the current position.
   //! \note It is assumed that the provided position is within the element.
   //! \param current_element The current element being traversed
@@ -158,6 +222,21 @@ public:
 
   BoundingBox element_bounding_box(MeshID element) const;
 
+  //! \brief Compute the bounding boxes of a set of elements in parallel.
+  //! Elements of the flat tetrahedral mesh are read from its arrays without
+  //! allocating memory per element.
+  //! \param elements The element IDs
+  //! \return The bounding box of each element, in the order given
+  std::vector<BoundingBox> element_bounding_boxes(const std::vector<MeshID>& elements) const
+  { return element_bounding_boxes(elements.data(), elements.size()); }
+
+  //! \brief Compute the bounding boxes of a contiguous array of elements in parallel
+  std::vector<BoundingBox> element_bounding_boxes(const MeshID* elements, size_t n_elements) const;
+
+  //! \brief Get the coordinates of the first four vertices of an element,
+  //! read from the flat tetrahedral mesh if it contains the element
+  std::array<Vertex, 4> tet_vertices(MeshID element) const;
+
   BoundingBox face_bounding_box(MeshID element) const;
 
   BoundingBox surface_bounding_box(MeshID surface) const;
@@ -168,10 +247,25 @@ public:
 
   Direction face_normal(MeshID element) const;
 
+  //! \brief Plane of a face, read from the face plane cache if it has been built
+  FacePlane face_plane(MeshID element) const;
+
   // Topology
   // Returns parent with forward sense, then reverse
   std::pair<MeshID, MeshID> get_parent_volumes(MeshID surface) const;
 
+  //! \brief Snapshot the volume-surface topology into dense tables that
+  //! serve get_parent_volumes, next_volume, surface_senses and
+  //! get_volume_surfaces without calling into the mesh library. Called at
+  //! the end of init(). Modifying the topology discards the snapshot.
+  void build_topology();
+
+  //! \brief Whether the topology snapshot has been built
+  bool has_topology() const { return !topology_.empty(); }
+
+  //! \brief Topology snapshot (empty if not built)
+  const TopologyTable& topology() const { return topology_; }
+
   virtual std::vector<MeshID> get_volume_surfaces(MeshID volume) const = 0;
 
   virtual std::pair<MeshID, MeshID> surface_senses(MeshID surface) const = 0;
@@ -197,8 +291,30 @@ public:
   bool volume_has_property(MeshID volume, PropertyType type) const;
   bool surface_has_property(MeshID surface, PropertyType type) const;
 
-  Property get_volume_property(MeshID volume, PropertyType type) const;
-  Property get_surface_property(MeshID surface, PropertyType type) const;
+  const Property& get_volume_property(MeshID volume, PropertyType type) const;
+  const Property& get_surface_property(MeshID surface, PropertyType type) const;
+
+  //! \brief Compile the volume and surface metadata into interned property
+  //! tables. Once built, the property queries above and the PropertyID
+  //! lookups below read the tables. Called at the end of parse_metadata.
+  void build_property_tables();
+
+  //! \brief Whether the property tables have been built
+  bool has_property_tables() const { return !volume_properties_.empty() || !surface_properties_.empty(); }
+
+  //! \brief Interned properties of the volumes
+  const PropertyTable& volume_properties() const { return volume_properties_; }
+
+  //! \brief Interned properties of the surfaces
+  const PropertyTable& surface_properties() const { return surface_properties_; }
+
+  //! \brief PropertyID of a volume property (PROPERTY_NONE if not assigned or the tables are not built)
+  PropertyID volume_property_id(MeshID volume, PropertyType type) const
+  { return volume_properties_.id(volume, type); }
+
+  //! \brief PropertyID of a surface property (PROPERTY_NONE if not assigned or the tables are not built)
+  PropertyID surface_property_id(MeshID surface, PropertyType type) const
+  { return surface_properties_.id(surface, type); }
 
   // Accessors
   const std::vector<MeshID>& volumes() const { return volumes_; }
@@ -210,6 +326,8 @@ public:
   virtual MeshLibrary mesh_library() const = 0;
 
 protected:
+  //! Discard the topology snapshot, e.g. when a surface is added to a volume
+  void invalidate_topology() { topology_ = TopologyTable(); }
 
   // metadata
   std::map<std::pair<MeshID, PropertyType>, Property> volume_metadata_;
@@ -227,6 +345,34 @@ protected:
   // TODO: attempt to remove this attribute
   MeshID implicit_complement_ {ID_NONE};
 
+  //! Flat copy of the volume elements used to walk rays through the mesh
+  std::shared_ptr<TetMesh> tet_mesh_ {nullptr};
+
+  //! Block ID mapping from surface face IDs to a dense index, in ID order
+  IDBlockMapping<MeshID> face_id_map_;
+
+  //! Index in face_planes_ of the plane of each surface face, indexed through face_id_map_
+  std::vector<MeshIndex> face_plane_indices_;
+
+  //! Index in face_planes_ of the plane of the first face of each surface
+  std::unordered_map<MeshID, MeshIndex> surface_plane_offsets_;
+
+  //! Cached face planes: the surface faces grouped by surface, followed by
+  //! the faces of the flat tetrahedral mesh that lie on no surface
+  std::vector<FacePlane> face_planes_;
+
+  //! Volume containing each volume element, indexed by element index
+  std::vector<MeshID> element_volumes_;
+
+  //! Interned properties of each volume (empty until built)
+  PropertyTable volume_properties_;
+
+  //! Interned properties of each surface (empty until built)
+  PropertyTable surface_properties_;
+
+  //! Snapshot of the volume-surface topology (empty until built)
+  TopologyTable topology_;
+
 private:
   // Returning this struct lets us call the same function to return local mesh data for both vertices and connectivity
   struct LocalMeshData {
@@ -302,6 +448,42 @@ private:
   LocalMeshData volume_local_mesh_data(MeshID volume) const;
 };
 
+template<typename Visitor>
+double MeshManager::walk_elements(MeshID starting_element,
+                                  const Position& start,
+                                  const Direction& u,
+                                  double distance,
+                                  Visitor&& visitor) const
+{
+  if (tet_mesh_ && tet_mesh_->contains(starting_element))
+    return tet_mesh_->walk_elements(starting_element, start, u, distance, visitor);
+
+  // a copy of the start position that will be updated as elements are traversed
+  Position r = start;
+  double traveled = 0.0;
+
+  MeshID elem = starting_element;
+  while (distance > 0) {
+    // find the exit point from the current element and determine the next element
+    // if one exists
+    auto exit = next_element(elem, r, u);
+    // ensure we are not traveling beyond the end of the ray
+    exit.second = std::min(exit.second, distance);
+    distance -= exit.second;
+    traveled += exit.second;
+    if (!visitor(elem, exit.second)) break;
+    r += exit.second * u;
+    elem = exit.first;
+
+    // if there is no next element, we're exiting the mesh
+    if (elem == ID_NONE) {
+      break;
+    }
+  }
+
+  return traveled;
+}
+
 } // namespace xdg
 
 #endif
@@ -1,14 +1,19 @@
 #ifndef _MBDIRECTACCESS_
 #define _MBDIRECTACCESS_
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 // MOAB
 #include "moab/Core.hpp"
 #include "moab/CartVect.hpp"
 
 #include "xdg/constants.h"
+#include "xdg/error.h"
 #include "xdg/id_block_map.h"
 #include "xdg/vec3da.h"
 
@@ -35,16 +40,7 @@ public:
 
   //! \brief Check that a triangle is part of the managed coordinates here
   inline bool accessible(EntityHandle tri) {
-    // determine the correct contiguous memory block index to use
-    int block_idx = 0;
-    auto fe = face_data_.first_elements[block_idx];
-    while(true) {
-      if (tri - fe.first < fe.second) { break; }
-      block_idx++;
-      if (block_idx >= face_data_.first_elements.size()) { return false; }
-      fe = face_data_.first_elements[block_idx];
-    }
-    return true;
+    return face_data_.contains(tri);
   }
 
   //! \brief Get the coordinates of a triangle as XDG Vertices
@@ -84,15 +80,31 @@ public:
 
   //! \brief Get the adjacent element
   inline EntityHandle get_adjacent_element(const EntityHandle& element, int face_number) {
-    return element_adjacency_data_.get_adjacent_element(element, face_number);
+    return element_adjacency_data_.get_adjacent_element(element_data_.index(element), face_number);
   }
 
   inline std::vector<EntityHandle> get_element_adjacencies(const EntityHandle& element) {
-    return element_adjacency_data_.get_element_adjacencies(element);
+    return element_adjacency_data_.get_element_adjacencies(element_data_.index(element));
   }
 
   inline EntityHandle get_boundary_face_element(const EntityHandle& face) const {
-    return boundary_face_adjacency_data_.get_boundary_face_element(face);
+    if (!face_data_.contains(face)) return xdg::ID_NONE;
+    return element_adjacency_data_.get_boundary_face_element(face_data_.index(face));
+  }
+
+  //! \brief Get the handle of a triangle from its ID
+  inline EntityHandle face_handle(MeshID face) const {
+    return face_data_.handle_from_id(face);
+  }
+
+  //! \brief Get the handle of an element from its ID
+  inline EntityHandle element_handle(MeshID element) const {
+    return element_data_.handle_from_id(element);
+  }
+
+  //! \brief Get the ID of an element from its handle
+  inline MeshID element_id(EntityHandle element) const {
+    return element - element_data_.id_offset;
   }
 
   const std::vector<std::vector<int>>& get_face_ordering(EntityType entity_type) const {
@@ -106,74 +118,82 @@ public:
 private:
   Interface* mbi {nullptr}; //!< MOAB instance for the managed data
 
+  /*! Dense map from the handles spanned by a set of contiguous blocks to the
+      block holding each handle, resolving a handle's block in constant time
+      however fragmented the blocks are. */
+  struct BlockIndex {
+    EntityHandle min_handle {0}; //!< Smallest handle in any block
+    std::vector<int32_t> blocks; //!< Block of each handle from min_handle on (-1 if in no block)
+
+    void setup(const std::vector<std::pair<EntityHandle, size_t>>& first_entities) {
+      blocks.clear();
+      if (first_entities.empty()) return;
+      min_handle = first_entities.front().first;
+      EntityHandle max_handle = min_handle;
+      for (const auto& fe : first_entities) {
+        min_handle = std::min(min_handle, fe.first);
+        max_handle = std::max(max_handle, fe.first + fe.second);
+      }
+      blocks.assign(max_handle - min_handle, -1);
+      for (size_t b = 0; b < first_entities.size(); b++) {
+        auto begin = blocks.begin() + (first_entities[b].first - min_handle);
+        std::fill(begin, begin + first_entities[b].second, static_cast<int32_t>(b));
+      }
+    }
+
+    //! \brief Block holding a handle (-1 if the handle is in no block)
+    int32_t block(EntityHandle e) const {
+      size_t i = e - min_handle;
+      return i < blocks.size() ? blocks[i] : -1;
+    }
+
+    //! \brief Block holding a handle, reporting an error if the handle is in no block
+    int32_t checked_block(EntityHandle e) const {
+      int32_t b = block(e);
+      if (b == -1) fatal_error("Entity handle {} is not managed by direct access", e);
+      return b;
+    }
+
+    void clear() {
+      min_handle = 0;
+      blocks.clear();
+    }
+  };
+
+  struct ConnectivityData;
+  struct VertexData;
+
+  /*! Element neighbors stored in a dense array addressed by element index
+      (the position of an element in the managed entity range, matching the
+      IDBlockMapping index space), one entry per element face. Built by
+      matching the sorted vertices of every element face, which also
+      identifies the owning element of each boundary triangle. */
   struct AdjacencyData {
     EntityType entity_type {MBTET}; //!< Type of entity stored in this manager
     int num_entities {-1}; //!< Number of elements in the manager
-    std::unordered_map<EntityHandle, std::vector<EntityHandle>> adj_info_;
+    size_t faces_per_element {4}; //!< Number of faces of each element
+    std::vector<EntityHandle> neighbors; //!< Element across each face of each element (ID_NONE on boundaries)
+    std::vector<EntityHandle> boundary_face_elements; //!< Element adjacent to each boundary triangle (ID_NONE otherwise)
 
-    void setup(Interface* mbi) {
-      ErrorCode rval;
+    void setup(const ConnectivityData& element_data, const ConnectivityData& face_data, const VertexData& vertex_data);
 
-      // setup element adjacenty data
-      // TODO: support other element types
-      Range elements;
-      rval = mbi->get_entities_by_type(mbi->get_root_set(), entity_type, elements, true);
-      MB_CHK_SET_ERR_CONT(rval, "Failed to get MOAB element adjacencies");
-
-      const auto& ord = ordering[entity_type];
-      // loop over elements and setup adjacency data
-      for (auto element : elements) {
-        adj_info_[element] = std::vector<EntityHandle>(ord.size(), xdg::ID_NONE);
-        // get element connectivity
-        std::vector<EntityHandle> conn;
-        rval = mbi->get_connectivity(&element, 1, conn);
-
-        // use ordering and adjacency call with intersection to populate adjacency entry
-        for (int i = 0; i < ord.size(); i++) {
-          auto o = ord[i];
-          // determine element for this face
-          std::vector<EntityHandle> verts;
-          for (auto idx : o) verts.push_back(conn[idx]);
-          Range adj_ents;
-          rval = mbi->get_adjacencies(verts.data(), verts.size(), 3, false, adj_ents);
-
-          // there be at most two adjacent elements for a given face
-          if (adj_ents.size() > 2) {
-            throw std::runtime_error("Something went wrong gathering adjacent face");
-          }
-
-          // if only one adjacent element, the face is on a boundary
-          if (adj_ents.size() == 1) {
-            // in this case, the returned element must be the current element itself
-            if (adj_ents[0] != element) {
-              throw std::runtime_error("The face is on a boundary, but the returned adjacent element is not the current element");
-            }
-            // if this face is on the boundary, there is no adjacency to add. Move on to the next face
-            continue;
-          }
-
-          if (adj_ents.size() == 2) {
-            if (adj_ents[0] == element) {
-            adj_info_[element][i] = adj_ents[1];
-          } else {
-            adj_info_[element][i] = adj_ents[0];
-          }
-          }
-        }
-      }
+    EntityHandle get_adjacent_element(size_t element_index, int face_number) const {
+      return neighbors[faces_per_element * element_index + face_number];
     }
 
-    EntityHandle get_adjacent_element(const EntityHandle& element, int face_number) {
-      return adj_info_[element][face_number];
+    std::vector<EntityHandle> get_element_adjacencies(size_t element_index) const {
+      return {neighbors.begin() + faces_per_element * element_index,
+              neighbors.begin() + faces_per_element * (element_index + 1)};
     }
 
-    std::vector<EntityHandle> get_element_adjacencies(const EntityHandle& element) {
-      return adj_info_[element];
+    EntityHandle get_boundary_face_element(size_t face_index) const {
+      return boundary_face_elements[face_index];
     }
 
     void clear() {
       num_entities = -1;
-      adj_info_.clear();
+      neighbors.clear();
+      boundary_face_elements.clear();
     }
 
     // ordering of element faces based on the cannonical ordering descibed here:
@@ -182,12 +202,16 @@ private:
     {MBTET, {{0, 1, 3}, {1, 2, 3}, {2, 0, 3}, {0, 2, 1}}}
     };
   };
+
   struct ConnectivityData {
     EntityType entity_type {MBMAXTYPE}; //!< Type of entity stored in this manager
     int num_entities {-1}; //!< Number of elements in the manager
     int element_stride {-1}; //!< Number of vertices used by each element
     std::vector<std::pair<EntityHandle, size_t>> first_elements; //!< Pairs of first element and length pairs for contiguous blocks of memory
+    std::vector<size_t> first_indices; //!< Index of the first element of each contiguous block
     std::vector<const EntityHandle*> vconn; //!< Storage array(s) for the connectivity array
+    BlockIndex block_index; //!< Block holding each managed entity
+    EntityHandle id_offset {0}; //!< Difference between the handle and ID of entities of this type
     moab::Range entity_range; //!< Range of entities managed here
 
     void setup(Interface * mbi) {
@@ -212,27 +236,47 @@ private:
 
         // set const pointers for the connectivity array and add first element/length pair to the set of first elements
         vconn.push_back(conntmp);
+        first_indices.push_back(first_elements.empty() ? 0 : first_indices.back() + first_elements.back().second);
         first_elements.push_back({*entity_it, n_elements});
 
         // move iterator forward by the number of triangles in this contiguous memory block
         entity_it += n_elements;
       }
+
+      block_index.setup(first_elements);
+      if (!entity_range.empty()) id_offset = *entity_range.begin() - mbi->id_from_handle(*entity_range.begin());
+    }
+
+    //! \brief Check that an entity is part of the managed entity range
+    bool contains(const EntityHandle& e) const {
+      return block_index.block(e) != -1;
+    }
+
+    //! \brief Index of an entity in the managed entity range
+    size_t index(const EntityHandle& e) const {
+      int32_t block_idx = block_index.checked_block(e);
+      return first_indices[block_idx] + (e - first_elements[block_idx].first);
+    }
+
+    //! \brief Handle of an entity from its ID
+    EntityHandle handle_from_id(MeshID id) const {
+      return id_offset + id;
+    }
+
+    //! \brief Handle of the entity at an index in the managed entity range
+    EntityHandle handle(size_t i) const {
+      size_t block_idx = std::upper_bound(first_indices.begin(), first_indices.end(), i) - first_indices.begin() - 1;
+      return first_elements[block_idx].first + (i - first_indices[block_idx]);
     }
 
     template <int N>
     std::array<size_t, N>
     get_connectivity_indices(const EntityHandle& e) const {
       // determine the correct contiguous block index to use
-      int block_idx = 0;
-      auto fe = first_elements[block_idx];
-      while(true) {
-        if (e - fe.first < fe.second) { break; }
-        block_idx++;
-        fe = first_elements[block_idx];
-      }
+      int32_t block_idx = block_index.checked_block(e);
 
       std::array<size_t, N> indices;
-      size_t conn_idx = element_stride * (e - fe.first);
+      size_t conn_idx = element_stride * (e - first_elements[block_idx].first);
       for (int i = 0; i < N; i++) {
         indices[i] = vconn[block_idx][conn_idx + i];
       }
@@ -243,48 +287,14 @@ private:
       num_entities = -1;
       element_stride = -1;
       first_elements.clear();
+      first_indices.clear();
       vconn.clear();
+      block_index.clear();
+      id_offset = 0;
       entity_range.clear();
     }
   };
 
-  struct BoundaryFaceAdjacencyData {
-    std::unordered_map<EntityHandle, EntityHandle> boundary_face_to_element_;
-
-    void setup(Interface* mbi, const ConnectivityData& face_data) {
-      ErrorCode rval;
-
-      for (const auto& face : face_data.entity_range) {
-        auto conn = face_data.get_connectivity_indices<3>(face);
-        std::array<EntityHandle, 3> verts = {conn[0], conn[1], conn[2]};
-
-        Range adjacent_elements;
-        rval = mbi->get_adjacencies(verts.data(), verts.size(), 3, true, adjacent_elements);
-        MB_CHK_SET_ERR_CONT(rval, "Failed to get MOAB boundary face adjacencies");
-
-        if (adjacent_elements.size() > 2) {
-          throw std::runtime_error("Found more than two elements adjacent to a face");
-        }
-
-        if (adjacent_elements.size() == 1) {
-          boundary_face_to_element_[face] = adjacent_elements[0];
-        }
-      }
-    }
-
-    EntityHandle get_boundary_face_element(const EntityHandle& face) const {
-      auto it = boundary_face_to_element_.find(face);
-      if (it == boundary_face_to_element_.end()) {
-        return xdg::ID_NONE;
-      }
-      return it->second;
-    }
-
-    void clear() {
-      boundary_face_to_element_.clear();
-    }
-  };
-
   struct VertexData {
     void setup(Interface* mbi) {
       ErrorCode rval;
@@ -313,6 +323,8 @@ private:
         // move iterator forward by the number of vertices in this contiguous memory block
         verts_it += n_vertices;
       }
+
+      block_index.setup(first_vertices);
     }
 
     void clear() {
@@ -321,6 +333,7 @@ private:
       ty.clear();
       tz.clear();
       first_vertices.clear();
+      block_index.clear();
       vertex_range.clear();
     }
 
@@ -329,13 +342,9 @@ private:
     //! \param v The vertex to set the coordinates of
     void set_coords(int i, xdg::Vertex& v) {
       // determine the correct contiguous memory block index to use
-      int idx = 0;
-      auto fe = first_vertices[idx];
-      while(i - fe.first >= fe.second) {
-        fe = first_vertices[++idx];
-      }
+      int32_t idx = block_index.checked_block(i);
       // determine index into the contiguous block of coordinate memory
-      i -= fe.first;
+      i -= first_vertices[idx].first;
       // populate the vertex reference with coordinates
       v = xdg::Vertex(tx[idx][i], ty[idx][i], tz[idx][i]);
     }
@@ -345,13 +354,13 @@ private:
     std::vector<const double*> ty; //!< Storage array(s) for vertex y coordinates
     std::vector<const double*> tz; //!< Storage array(s) for vertex z coordinates
     std::vector<std::pair<EntityHandle, size_t>> first_vertices; //!< Pairs of first vertex and length pairs for contiguous blocks of memory
+    BlockIndex block_index; //!< Block holding each managed vertex
     moab::Range vertex_range; //!< Range of vertices managed here
   };
 
   ConnectivityData face_data_;
   ConnectivityData element_data_;
   AdjacencyData element_adjacency_data_;
-  BoundaryFaceAdjacencyData boundary_face_adjacency_data_;
   VertexData vertex_data_;
 
   public:
@@ -14,6 +14,7 @@ struct PrimitiveRef {
 void TriangleIntersectionFunc(RTCIntersectFunctionNArguments* args);
 void TriangleBoundsFunc(RTCBoundsFunctionArguments* args);
 void TriangleOcclusionFunc(RTCOccludedFunctionNArguments* args);
+void TriangleIntersectionFilterFunc(const RTCFilterFunctionNArguments* args);
 bool TriangleClosestFunc(RTCPointQueryFunctionArguments* args);
 
 } // namespace xdg
@@ -0,0 +1,75 @@
+#ifndef _XDG_PROPERTY_TABLE_H
+#define _XDG_PROPERTY_TABLE_H
+
+#include <array>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xdg/constants.h"
+#include "xdg/id_block_map.h"
+
+namespace xdg {
+
+/*! Compiled form of the properties assigned to a set of volumes or surfaces.
+
+    The values of each property type are interned, each distinct value being
+    stored once and identified by a small integer PropertyID. The PropertyID
+    of every entity is kept in a dense array per property type, indexed
+    through a block mapping of the entity IDs, so a lookup reads an array
+    rather than searching a map or copying strings. A check against a fixed
+    value (e.g. a reflecting boundary) compares the PropertyID of an entity
+    with the PropertyID of the value, found once with value_id.
+ */
+class PropertyTable {
+public:
+  PropertyTable() = default;
+
+  //! \brief Compile the properties of a set of entities
+  //! \param entities IDs of the entities (in any order)
+  //! \param metadata Property of each entity and property type. Entries for
+  //! entities not in the set are ignored.
+  PropertyTable(const std::vector<MeshID>& entities,
+                const std::map<std::pair<MeshID, PropertyType>, Property>& metadata);
+
+  //! \brief PropertyID of an entity's property of a type
+  //! \return The PropertyID, or PROPERTY_NONE if the entity has no property
+  //! of that type or is not in the table
+  PropertyID id(MeshID entity, PropertyType type) const
+  {
+    MeshIndex idx = entity_map_.id_to_index(entity);
+    return idx == INDEX_NONE ? PROPERTY_NONE : ids_[type_index(type)][idx];
+  }
+
+  //! \brief Interned value of a property (the PropertyID must be valid)
+  const Property& value(PropertyType type, PropertyID id) const { return values_[type_index(type)][id]; }
+
+  //! \brief Interned values of a property type, indexed by PropertyID
+  const std::vector<Property>& values(PropertyType type) const { return values_[type_index(type)]; }
+
+  //! \brief PropertyID of a value of a property type
+  //! \return The PropertyID, or PROPERTY_NONE if no entity has that value
+  PropertyID value_id(PropertyType type, const std::string& value) const;
+
+  //! \brief Number of entities in the table
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+private:
+  static constexpr size_t N_PROPERTY_TYPES {4};
+
+  //! Position of a property type in the per-type arrays
+  static size_t type_index(PropertyType type)
+  { return static_cast<int>(type) - static_cast<int>(PropertyType::BOUNDARY_CONDITION); }
+
+  IDBlockMapping<MeshID> entity_map_; //!< Block ID mapping from entity IDs to contiguous indices
+  std::array<std::vector<PropertyID>, N_PROPERTY_TYPES> ids_; //!< PropertyID of each entity, per type
+  std::array<std::vector<Property>, N_PROPERTY_TYPES> values_; //!< Interned values, per type
+  size_t size_ {0}; //!< Number of entities
+};
+
+} // namespace xdg
+
+#endif // include guard
@@ -10,6 +10,7 @@
 #include "xdg/constants.h"
 #include "xdg/embree_interface.h"
 #include "xdg/primitive_ref.h"
+#include "xdg/ray_history.h"
 
 namespace xdg {
 
@@ -88,6 +89,7 @@ struct RTCSurfaceDualRay : RTCDualRay {
   RayFireType rf_type {RayFireType::VOLUME}; //!< Enum indicating the type of query this ray is used for
   HitOrientation orientation {HitOrientation::EXITING}; //!< Enum indicating what hits to accept based on orientation
   const std::vector<MeshID>* exclude_primitives {nullptr}; //! < Set of primitives to exclude from the query
+  const RayHistory* history {nullptr}; //!< Recently crossed primitives to exclude from the query
   TreeID volume_tree {ID_NONE}; // volume the ray is being fired in
 };
 
@@ -128,6 +130,14 @@ struct RTCDualRayHit {
 
 };
 
+/*! Ray query context carrying the double precision ray/hit through Embree's
+    filter callbacks. Used when surfaces are represented as native Embree
+    triangle geometries, where Embree operates on a plain RTCRayHit. */
+struct RTCDualRayQueryContext {
+  RTCRayQueryContext context; //<! Embree query context, must remain the first member
+  RTCDualRayHit* rayhit {nullptr}; //<! Double precision ray/hit being resolved by the query
+};
+
 /*! Structure extending Embree's RTCPointQuery to include double precision values */
 struct RTCDPointQuery : RTCPointQuery {
 
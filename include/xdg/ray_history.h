@@ -0,0 +1,66 @@
+#ifndef _XDG_RAY_HISTORY_H
+#define _XDG_RAY_HISTORY_H
+
+#include <array>
+#include <cstddef>
+
+#include "xdg/constants.h"
+
+namespace xdg {
+
+/*! Fixed-capacity record of the primitives most recently crossed by a ray.
+
+    Primitives in the history are excluded from subsequent ray queries so that
+    a ray launched from a surface does not re-intersect the face it just
+    crossed. Only the last CAPACITY crossings are kept, the oldest entry being
+    evicted when a new one is added, so membership tests cost the same no
+    matter how many surfaces a particle has crossed.
+ */
+class RayHistory {
+public:
+  static constexpr size_t CAPACITY {8}; //!< Maximum number of primitives retained
+
+  //! \brief Record a crossed primitive, evicting the oldest entry if the history is full
+  void push_back(MeshID primitive) {
+    entries_[head_] = primitive;
+    head_ = (head_ + 1) % CAPACITY;
+    if (size_ < CAPACITY) size_++;
+  }
+
+  //! \brief Whether the primitive is one of the retained crossings
+  bool contains(MeshID primitive) const {
+    for (size_t i = 0; i < size_; ++i) {
+      if (entries_[i] == primitive) return true;
+    }
+    return false;
+  }
+
+  //! \brief The most recently crossed primitive (the history must not be empty)
+  MeshID back() const { return entries_[(head_ + CAPACITY - 1) % CAPACITY]; }
+
+  //! \brief The i-th retained primitive, ordered from oldest to most recent
+  MeshID operator[](size_t i) const { return entries_[(head_ + CAPACITY - size_ + i) % CAPACITY]; }
+
+  //! \brief Discard all entries except the most recent crossing
+  void reset_to_last() {
+    if (empty()) return;
+    MeshID last = back();
+    clear();
+    push_back(last);
+  }
+
+  void clear() { head_ = 0; size_ = 0; }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+private:
+  std::array<MeshID, CAPACITY> entries_; //!< Ring buffer of crossed primitives
+  size_t head_ {0}; //!< Slot the next crossing will be written to
+  size_t size_ {0}; //!< Number of valid entries
+};
+
+} // namespace xdg
+
+#endif // include guard
@@ -9,6 +9,8 @@
 #include "xdg/mesh_manager_interface.h"
 #include "xdg/primitive_ref.h"
 #include "xdg/geometry_data.h"
+#include "xdg/ray_history.h"
+#include "xdg/tree_cache.h"
 
 namespace xdg
 {
@@ -38,6 +40,22 @@ public:
   virtual std::pair<TreeID, TreeID>
   register_volume(const std::shared_ptr<MeshManager>& mesh_manager, MeshID volume) = 0;
 
+  /**
+   * @brief Registers a set of volumes with the ray tracer.
+   *
+   * Equivalent to calling register_volume for each volume in turn. The
+   * default implementation does exactly that; backends may override this
+   * to build the trees of independent volumes concurrently.
+   *
+   * @param mesh_manager A shared pointer to the MeshManager responsible for
+   * managing the volumes' mesh data.
+   * @param volumes The volumes to register.
+   * @return The surface and element TreeIDs of each volume, in the order of
+   *         the volumes provided.
+   */
+  virtual std::vector<std::pair<TreeID, TreeID>>
+  register_volumes(const std::shared_ptr<MeshManager>& mesh_manager, const std::vector<MeshID>& volumes);
+
   /**
    * @brief Creates a surface tree for a given volume.
    *
@@ -72,6 +90,14 @@ public:
    */
   virtual void create_global_element_tree() = 0;
 
+  /**
+   * @brief Builds the global element and surface trees.
+   *
+   * The default implementation builds the two trees one after the other;
+   * backends may override this to build them concurrently.
+   */
+  virtual void create_global_trees();
+
   // Query Methods
   virtual bool point_in_volume(TreeID tree,
                        const Position& point,
@@ -85,6 +111,130 @@ public:
                                      HitOrientation orientation = HitOrientation::EXITING,
                                      std::vector<MeshID>* const exclude_primitives = nullptr) = 0;
 
+  /**
+   * @brief Determines whether a point lies inside a volume, ignoring recently crossed primitives.
+   *
+   * The default implementation copies the history into an exclusion list;
+   * backends may override this to test the history directly.
+   *
+   * @param tree Surface tree of the volume to test against
+   * @param point Point to test
+   * @param direction Direction of the containment ray (may be nullptr)
+   * @param history Primitives to exclude from the query (may be nullptr)
+   */
+  virtual bool point_in_volume_with_history(TreeID tree,
+                                            const Position& point,
+                                            const Direction* direction,
+                                            const RayHistory* history) const;
+
+  /**
+   * @brief Fires a ray, ignoring recently crossed primitives.
+   *
+   * On a hit, the intersected primitive is appended to the history (evicting
+   * the oldest entry if the history is full). The default implementation
+   * copies the history into an exclusion list; backends may override this to
+   * test the history directly.
+   *
+   * @param tree Surface tree to fire the ray against
+   * @param origin Ray origin
+   * @param direction Ray direction
+   * @param dist_limit Maximum distance of the ray
+   * @param orientation Hit orientation to accept
+   * @param history Primitives to exclude from the query (may be nullptr)
+   * @return The distance to the hit and the surface hit (INFTY and ID_NONE on a miss)
+   */
+  virtual std::pair<double, MeshID> ray_fire_with_history(TreeID tree,
+                                                          const Position& origin,
+                                                          const Direction& direction,
+                                                          const double dist_limit,
+                                                          HitOrientation orientation,
+                                                          RayHistory* history);
+
+  /**
+   * @brief Determines whether each point in a batch lies inside a volume.
+   *
+   * All arrays are contiguous and of length n_points. The default
+   * implementation tests the points one at a time; backends that support
+   * concurrent queries may override this to process the batch in parallel.
+   *
+   * @param tree Surface tree of the volume to test against
+   * @param n_points Number of points in the batch
+   * @param points Points to test
+   * @param directions Direction of the containment ray for each point (may be nullptr)
+   * @param results Output containment of each point (INSIDE or OUTSIDE)
+   */
+  virtual void point_in_volume_batch(TreeID tree,
+                                     size_t n_points,
+                                     const Position* points,
+                                     const Direction* directions,
+                                     PointInVolume* results) const;
+
+  /**
+   * @brief Fires a batch of rays, each against its own tree.
+   *
+   * All arrays are contiguous and of length n_rays. The default
+   * implementation fires the rays one at a time; backends that support
+   * concurrent queries may override this to process the batch in parallel.
+   *
+   * @param n_rays Number of rays in the batch
+   * @param trees Tree to fire each ray against
+   * @param origins Ray origins
+   * @param directions Ray directions
+   * @param dist_limits Maximum distance of each ray (may be nullptr for no limit)
+   * @param distances Output distance to the hit for each ray (INFTY on a miss)
+   * @param surfaces Output surface hit by each ray (ID_NONE on a miss)
+   * @param orientation Hit orientation to accept for all rays in the batch
+   */
+  virtual void ray_fire_batch(size_t n_rays,
+                              const TreeID* trees,
+                              const Position* origins,
+                              const Direction* directions,
+                              const double* dist_limits,
+                              double* distances,
+                              MeshID* surfaces,
+                              HitOrientation orientation = HitOrientation::EXITING);
+
+  /**
+   * @brief Identifies the volume containing a point from the first surface
+   * hit by rays fired through a surface tree containing the surfaces of all
+   * volumes (e.g. the global surface tree).
+   *
+   * Rays that only graze a face are fired again in other directions, and a
+   * point is placed in the implicit complement once two rays escape.
+   *
+   * @param tree Surface tree to fire rays against
+   * @param mesh_manager Mesh manager of the surfaces in the tree
+   * @param point Point to locate
+   * @param direction Direction of the first ray
+   * @param volume Output volume containing the point
+   * @return Whether a ray gave a reliable answer
+   */
+  bool find_volume_by_ray(TreeID tree,
+                          const MeshManager& mesh_manager,
+                          const Position& point,
+                          const Direction& direction,
+                          MeshID& volume);
+
+  /**
+   * @brief Identifies the volume containing each point in a batch as in
+   * find_volume_by_ray.
+   *
+   * All arrays are contiguous and of length n_points. The default
+   * implementation locates the points one at a time; backends that support
+   * concurrent queries may override this to process the batch in parallel.
+   *
+   * @param directions Direction of the first ray for each point (may be nullptr)
+   * @param volumes Output volume containing each resolved point
+   * @param resolved Output flag set for each point a ray gave a reliable answer for
+   */
+  virtual void find_volume_by_ray_batch(TreeID tree,
+                                        const MeshManager& mesh_manager,
+                                        size_t n_points,
+                                        const Position* points,
+                                        const Direction* directions,
+                                        MeshID* volumes,
+                                        bool* resolved);
+
   /**
    * @brief Finds the element containing a given point using the global element tree.
    *
@@ -106,6 +256,33 @@ public:
    */
   virtual MeshID find_element(TreeID tree, const Position& point) const = 0;
 
+  /**
+   * @brief Finds the elements containing a batch of points using the global element tree.
+   *
+   * @param n_points Number of points in the batch
+   * @param points Points to locate
+   * @param elements Output element containing each point (ID_NONE on a miss)
+   * @param missed Output flag set for each point that is not in any element (may be nullptr)
+   * @return The number of points that are not in any element
+   */
+  virtual size_t find_element_batch(size_t n_points,
+                                    const Position* points,
+                                    MeshID* elements,
+                                    bool* missed = nullptr) const;
+
+  /**
+   * @brief Finds the elements containing a batch of points using a specific tree.
+   *
+   * The default implementation locates the points one at a time; backends
+   * that support concurrent queries may override this to process the batch
+   * in parallel.
+   */
+  virtual size_t find_element_batch(TreeID tree,
+                                    size_t n_points,
+                                    const Position* points,
+                                    MeshID* elements,
+                                    bool* missed = nullptr) const;
+
   virtual std::pair<double, MeshID> closest(TreeID tree,
                                             const Position& origin) = 0;
 
@@ -116,12 +293,43 @@ public:
 
   virtual RTLibrary library() const = 0;
 
+  /**
+   * @brief Whether queries may be made from several threads at once.
+   *
+   * Backends whose queries share state between calls (e.g. device buffers)
+   * return false, and callers must not query them concurrently.
+   */
+  virtual bool concurrent_queries() const { return false; }
+
+
+  /**
+   * @brief Sets a cache of mesh data to build trees from.
+   *
+   * Trees created after this call read the faces, vertices and elements of
+   * cached surfaces and volumes from the cache instead of the mesh manager.
+   * Backends that do not support caching ignore it.
+   */
+  void set_tree_cache(std::shared_ptr<const TreeCache> cache) { tree_cache_ = cache; }
+
+  const std::shared_ptr<const TreeCache>& tree_cache() const { return tree_cache_; }
+
+  /**
+   * @brief Key of the parameters that affect how trees are built.
+   *
+   * Mixed into the tree cache key so that a cache is not reused by a ray
+   * tracer configured differently. Backends with their own build options
+   * extend the key of the base class.
+   */
+  virtual uint64_t tree_build_key() const;
 
   // Generic Accessors
   int num_registered_trees() const { return surface_trees_.size() + element_trees_.size(); };
   int num_registered_surface_trees() const { return surface_trees_.size(); };
   int num_registered_element_trees() const { return element_trees_.size(); };
 
+  //! TreeID of the global surface tree (TREE_NONE if it has not been built)
+  SurfaceTreeID global_surface_tree() const { return global_surface_tree_; }
+
 protected:
   // Common functions across RayTracers
   const double bounding_box_bump(const std::shared_ptr<MeshManager> mesh_manager, MeshID volume_id); // return a bump value based on the size of a bounding box (minimum 1e-3). Should this be a part of mesh_manager?
@@ -140,6 +348,8 @@ protected:
   std::vector<SurfaceTreeID> surface_trees_; //<! All surface trees created by this ray tracer
   std::vector<ElementTreeID> element_trees_; //<! All element trees created by this ray tracer
 
+  std::shared_ptr<const TreeCache> tree_cache_ {nullptr}; //<! Cached mesh data used to build trees
+
   // Internal parameters
   SurfaceTreeID next_surface_tree_id_ {0};
   ElementTreeID next_element_tree_id_ {0};
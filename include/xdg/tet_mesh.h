@@ -0,0 +1,181 @@
+#ifndef _XDG_TET_MESH_H
+#define _XDG_TET_MESH_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "xdg/constants.h"
+#include "xdg/geometry/face_common.h"
+#include "xdg/vec3da.h"
+
+namespace xdg {
+
+class MeshManager; // Forward declaration
+
+/*! Flat copy of the tetrahedra of a mesh used to walk rays through elements.
+
+    Elements, vertices and neighbors are stored in contiguous arrays indexed
+    by a dense element index so that each step of a walk reads the exit face
+    candidates and the next element directly, without allocating or calling
+    into the mesh library. The faces of each element are stored in the order
+    used by MeshManager::adjacent_element, with vertices ordered so that face
+    normals point out of the element.
+
+    The exit face of an element is found from the Plucker products of the ray
+    with the six edges of the element, each computed once and shared by the
+    two faces on either side of the edge. The face a ray entered through is
+    carried from one step to the next and only tested if the ray leaves
+    through no other face. If the face planes have been built, the distance
+    to the exit point is taken from the plane of the exit face.
+ */
+class TetMesh {
+public:
+  //! Copy the volume elements of a mesh. Returns nullptr if the mesh has no
+  //! volume elements or any of them is not a tetrahedron.
+  static std::shared_ptr<TetMesh> from_mesh(const MeshManager& mesh_manager);
+
+  //! Point each element face at its plane in a face plane cache, appending
+  //! the planes of faces not yet in the cache. The two elements sharing a
+  //! face share its plane, as do element faces matching one of the cached
+  //! faces given by their sorted vertex IDs. The cache must not be modified
+  //! afterwards.
+  void build_face_planes(std::vector<FacePlane>& planes,
+                         const std::map<std::array<MeshID, 3>, MeshIndex>& cached_faces);
+
+  //! \brief Walk through elements along a ray with specified direction and distance
+  //! \note It is assumed that the provided position is within the starting element.
+  //! \param starting_element The initial element to start the walk from
+  //! \param start The starting position of the ray
+  //! \param u The normalized direction vector of the ray
+  //! \param distance The total distance to travel along the ray
+  //! \return Vector of pairs containing element IDs and distances traveled through each element
+  std::vector<std::pair<MeshID, double>>
+  walk_elements(MeshID starting_element,
+                const Position& start,
+                const Direction& u,
+                double distance) const;
+
+  //! \brief Walk through elements along a ray, passing each segment to a
+  //! visitor as it is found rather than collecting the segments
+  //! \param visitor Callable invoked as visitor(element ID, length) for each
+  //! element traversed. The walk stops early if it returns false.
+  //! \return The distance traveled through the visited elements
+  template<typename Visitor>
+  double walk_elements(MeshID starting_element,
+                       const Position& start,
+                       const Direction& u,
+                       double distance,
+                       Visitor&& visitor) const;
+
+  //! \brief Find the next element along a ray from the current position.
+  //! \note It is assumed that the provided position is within the element.
+  //! \param element Index of the current element
+  //! \param r The current position within the element
+  //! \param u The normalized direction vector of the ray
+  //! \return Pair containing the index of the next element (INDEX_NONE when
+  //! leaving the mesh) and the distance to the exit point
+  std::pair<MeshIndex, double>
+  next_element(MeshIndex element,
+               const Position& r,
+               const Direction& u) const;
+
+  //! \brief Find the face through which a ray leaves an element.
+  //! \note It is assumed that the provided position is within the element.
+  //! \param element Index of the current element
+  //! \param r The current position within the element
+  //! \param u The normalized direction vector of the ray
+  //! \param entry_face Face the ray entered the element through (-1 if unknown)
+  //! \return Pair containing the exit face (-1 if the ray leaves through no
+  //! face) and the distance to the exit point
+  std::pair<int, double>
+  exit_face(MeshIndex element,
+            const Position& r,
+            const Direction& u,
+            int entry_face = -1) const;
+
+  // Accessors
+  size_t num_elements() const { return element_ids_.size(); }
+
+  bool contains(MeshID element) const { return element_indices_.count(element); }
+
+  //! Index of an element in the flat arrays (INDEX_NONE if not present)
+  MeshIndex element_index(MeshID element) const;
+
+  MeshID element_id(MeshIndex element) const { return element_ids_[element]; }
+
+  //! Coordinates of the vertices of an element
+  std::array<Vertex, 4> element_vertices(MeshIndex element) const
+  {
+    const auto& connectivity = connectivity_[element];
+    return {vertices_[connectivity[0]], vertices_[connectivity[1]],
+            vertices_[connectivity[2]], vertices_[connectivity[3]]};
+  }
+
+  //! Index of the element across a face of an element (INDEX_NONE on the mesh boundary)
+  MeshIndex neighbor(MeshIndex element, int face) const { return neighbors_[element][face]; }
+
+  //! Face of the neighbor across a face of an element that is shared with the element (-1 on the mesh boundary)
+  int neighbor_face(MeshIndex element, int face) const { return neighbor_faces_[element][face]; }
+
+  bool has_face_planes() const { return face_planes_ != nullptr; }
+
+  //! Plane of a face of an element, which may face into or out of the
+  //! element (the face planes must have been built)
+  const FacePlane& face_plane(MeshIndex element, int face) const { return face_planes_[face_plane_indices_[element][face]]; }
+
+private:
+  TetMesh() = default;
+
+  std::vector<Vertex> vertices_; //!< Coordinates of all element vertices
+  std::vector<std::array<MeshIndex, 4>> connectivity_; //!< Vertex indices of each element
+  std::vector<std::array<int8_t, 12>> faces_; //!< Local vertices (0-3) of the four faces of each element
+  std::vector<std::array<MeshIndex, 4>> neighbors_; //!< Element across each face (INDEX_NONE on the mesh boundary)
+  std::vector<std::array<int8_t, 4>> neighbor_faces_; //!< Face of the neighbor shared with each face (-1 on the mesh boundary)
+  std::vector<std::array<MeshIndex, 4>> face_plane_indices_; //!< Index of the plane of each element face in face_planes_
+  const FacePlane* face_planes_ {nullptr}; //!< Face plane cache of the mesh manager (nullptr if not built)
+  std::vector<MeshID> vertex_ids_; //!< Mesh vertex ID of each vertex
+  std::vector<MeshID> element_ids_; //!< Element ID of each index
+  std::unordered_map<MeshID, MeshIndex> element_indices_; //!< Index of each element ID
+};
+
+template<typename Visitor>
+double TetMesh::walk_elements(MeshID starting_element,
+                              const Position& start,
+                              const Direction& u,
+                              double distance,
+                              Visitor&& visitor) const
+{
+  // a copy of the start position that will be updated as elements are traversed
+  Position r = start;
+  double traveled = 0.0;
+
+  MeshIndex elem = element_index(starting_element);
+  int entry_face = -1;
+  while (distance > 0) {
+    auto exit = exit_face(elem, r, u, entry_face);
+    // ensure we are not traveling beyond the end of the ray
+    exit.second = std::min(exit.second, distance);
+    distance -= exit.second;
+    traveled += exit.second;
+    if (!visitor(element_ids_[elem], exit.second)) break;
+    r += exit.second * u;
+
+    // if there is no next element, we're exiting the mesh
+    if (exit.first == -1) break;
+    entry_face = neighbor_faces_[elem][exit.first];
+    elem = neighbors_[elem][exit.first];
+    if (elem == INDEX_NONE) break;
+  }
+
+  return traveled;
+}
+
+} // namespace xdg
+
+#endif // include guard
@@ -36,6 +36,43 @@ bool plucker_tet_containment_test(const Position& point,
                                   const Vertex& v2,
                                   const Vertex& v3);
 
+/**
+ * @brief Affine map from positions to the barycentric coordinates of a
+ * tetrahedron (12 doubles).
+ *
+ * The barycentric coordinates of a point p with respect to vertices 1-3 are
+ * the dot products of rows[i] with p - origin. Precomputing this map moves
+ * the matrix inverse of a containment test to tree-build time. Plain arrays
+ * are used rather than Vec3da, which is padded to four doubles.
+ */
+struct TetTransform {
+  double origin[3]; //!< First vertex of the tetrahedron
+  double rows[3][3]; //!< Rows of the inverse of the edge matrix [v1 - v0, v2 - v0, v3 - v0]
+};
+
+static_assert(sizeof(TetTransform) == 12 * sizeof(double), "TetTransform must be packed to 12 doubles");
+
+/**
+ * @brief Compute the barycentric transform of a tetrahedron.
+ */
+TetTransform tet_transform(const Vertex& v0,
+                           const Vertex& v1,
+                           const Vertex& v2,
+                           const Vertex& v3);
+
+/**
+ * @brief Determines if a point is inside or on the boundary of a tetrahedron
+ * from its precomputed barycentric transform. Gives the same result as
+ * plucker_tet_containment_test for the vertices of the transform.
+ *
+ * @param point The position of the point to test.
+ * @param transform The barycentric transform of the tetrahedron.
+ * @return `true` if the point is inside or on the boundary of the tetrahedron,
+ * `false` otherwise.
+ */
+bool tet_transform_containment_test(const Position& point,
+                                    const TetTransform& transform);
+
 // Embree call back functions for element search
 void VolumeElementBoundsFunc(RTCBoundsFunctionArguments* args);
 void TetrahedronIntersectionFunc(RTCIntersectFunctionNArguments* args);
@@ -0,0 +1,69 @@
+#ifndef _XDG_TOPOLOGY_TABLE_H
+#define _XDG_TOPOLOGY_TABLE_H
+
+#include <utility>
+#include <vector>
+
+#include "xdg/constants.h"
+#include "xdg/id_block_map.h"
+
+namespace xdg {
+
+/*! Frozen snapshot of the volume-surface topology of a model.
+
+    The parent volumes of each surface are stored in a dense array indexed
+    through a block mapping of the surface IDs, so the volumes on either
+    side of a surface (and the volume across it) are found without calling
+    into the mesh library. The surfaces bounding each volume and their
+    senses with respect to that volume are stored in compressed sparse row
+    form, in the order reported by the mesh library.
+ */
+class TopologyTable {
+public:
+  TopologyTable() = default;
+
+  //! \brief Snapshot the topology of a model
+  //! \param volumes IDs of the volumes
+  //! \param volume_surfaces Surfaces bounding each volume
+  //! \param surfaces IDs of the surfaces
+  //! \param senses Forward and reverse volume of each surface (ID_NONE where unset)
+  TopologyTable(const std::vector<MeshID>& volumes,
+                const std::vector<std::vector<MeshID>>& volume_surfaces,
+                const std::vector<MeshID>& surfaces,
+                const std::vector<std::pair<MeshID, MeshID>>& senses);
+
+  //! \brief Forward and reverse volumes of a surface
+  //! \return The parent volumes, or {ID_NONE, ID_NONE} if the surface is not in the table
+  std::pair<MeshID, MeshID> surface_senses(MeshID surface) const
+  {
+    MeshIndex idx = surface_map_.id_to_index(surface);
+    return idx == INDEX_NONE ? std::make_pair(ID_NONE, ID_NONE) : senses_[idx];
+  }
+
+  //! \brief Sense of a surface with respect to a volume
+  //! \return FORWARD or REVERSE, or UNSET if the volume is not a parent of the surface
+  Sense surface_sense(MeshID surface, MeshID volume) const;
+
+  //! \brief Whether a volume is in the table
+  bool has_volume(MeshID volume) const { return volume_map_.id_to_index(volume) != INDEX_NONE; }
+
+  //! \brief Surfaces bounding a volume (empty if the volume is not in the table)
+  std::vector<MeshID> volume_surfaces(MeshID volume) const;
+
+  //! \brief Senses of the surfaces bounding a volume, in the order of volume_surfaces
+  std::vector<Sense> volume_surface_senses(MeshID volume) const;
+
+  bool empty() const { return senses_.empty() && volume_offsets_.size() < 2; }
+
+private:
+  IDBlockMapping<MeshID> surface_map_; //!< Block ID mapping from surface IDs to contiguous indices
+  std::vector<std::pair<MeshID, MeshID>> senses_; //!< Forward and reverse volume of each surface
+  IDBlockMapping<MeshID> volume_map_; //!< Block ID mapping from volume IDs to contiguous indices
+  std::vector<size_t> volume_offsets_; //!< Start of each volume's surfaces (n_volumes + 1 entries)
+  std::vector<MeshID> volume_surfaces_; //!< Surfaces of all volumes
+  std::vector<Sense> volume_senses_; //!< Sense of each entry of volume_surfaces_ with respect to its volume
+};
+
+} // namespace xdg
+
+#endif // include guard
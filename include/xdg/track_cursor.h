@@ -0,0 +1,112 @@
+#ifndef _XDG_TRACK_CURSOR_H
+#define _XDG_TRACK_CURSOR_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "xdg/constants.h"
+#include "xdg/vec3da.h"
+
+namespace xdg {
+
+class TetMesh; // Forward declaration
+class XDG; // Forward declaration
+
+/*! Resumable walk of a particle track through the volume elements of a mesh.
+
+    A transport code flies a particle as a series of flights, each starting
+    where the last one ended. The cursor keeps the element the particle is
+    in, the face it entered that element through and the volume it is in,
+    so each flight continues the element walk directly. The
+    starting point is located once, when the cursor is created or moved with
+    set_position. No other point location queries are made: when the track
+    leaves the mesh it is returned to it by a ray fired through the
+    implicit complement.
+
+    The direction may be changed between flights (e.g. after a collision)
+    without losing the current element.
+ */
+class TrackCursor {
+public:
+  // Constructors
+  //! \brief Locate the starting point of a track
+  TrackCursor(std::shared_ptr<const XDG> xdg,
+              const Position& position,
+              const Direction& direction);
+
+  //! \brief Advance the track, passing each segment to a visitor as it is found
+  //! \param distance Distance to move along the current direction
+  //! \param visitor Callable invoked as visitor(element, length) for each
+  //! segment. The track stops early if it returns false.
+  //! \return The distance moved
+  template<typename Visitor>
+  double advance(double distance, Visitor&& visitor);
+
+  //! \brief Advance the track, collecting its segments
+  //! \param distance Distance to move along the current direction
+  //! \return Vector of pairs containing element IDs and distances traveled through each element
+  std::vector<std::pair<MeshID, double>> advance(double distance);
+
+  //! \brief Move the cursor to a new position, locating the element containing it
+  void set_position(const Position& position);
+
+  //! \brief Change the direction of the track, keeping the current element
+  void set_direction(const Direction& direction);
+
+  // Accessors
+  const Position& position() const { return position_; }
+
+  const Direction& direction() const { return direction_; }
+
+  //! Element containing the current position (ID_NONE if outside of the mesh)
+  MeshID element() const { return element_; }
+
+  //! Volume containing the current position
+  MeshID volume() const;
+
+  //! Material of the volume containing the current position (see MeshManager::volume_properties)
+  PropertyID material() const;
+
+  //! Surface face crossed the last time the track entered the mesh (ID_NONE if it has not)
+  MeshID last_face() const { return last_face_; }
+
+private:
+  //! Move through at most one element, reducing the remaining distance.
+  //! Returns false, without moving through an element, if the track ends
+  //! before reaching another element.
+  bool step(double& distance, MeshID& element, double& length);
+
+  //! Return the track to the mesh through the implicit complement. Returns
+  //! false if no element is reached within the remaining distance.
+  bool enter_mesh(double& distance);
+
+  std::shared_ptr<const XDG> xdg_;
+  std::shared_ptr<const TetMesh> tet_mesh_; //!< Flat tet mesh of the model (nullptr if not built)
+  Position position_;
+  Direction direction_;
+  MeshID element_ {ID_NONE}; //!< Element containing the current position
+  MeshIndex element_index_ {INDEX_NONE}; //!< Index of the element in the flat tet mesh (INDEX_NONE if not present)
+  int entry_face_ {-1}; //!< Face of the flat tet mesh element the track entered through (-1 if unknown)
+  MeshID last_face_ {ID_NONE}; //!< Surface face crossed when last entering the mesh
+  mutable MeshID volume_ {ID_NONE}; //!< Volume containing the current position when outside of the mesh
+  mutable MeshID volume_element_ {ID_NONE}; //!< Element at which volume_ was determined
+  mutable Position volume_position_; //!< Position at which volume_ was determined
+  mutable bool volume_known_ {false};
+};
+
+template<typename Visitor>
+double TrackCursor::advance(double distance, Visitor&& visitor)
+{
+  double moved = distance;
+  MeshID element;
+  double length;
+  while (step(distance, element, length)) {
+    if (!visitor(element, length)) break;
+  }
+  return moved - distance;
+}
+
+} // namespace xdg
+
+#endif // include guard
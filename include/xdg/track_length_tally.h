@@ -0,0 +1,109 @@
+#ifndef _XDG_TRACK_LENGTH_TALLY_H
+#define _XDG_TRACK_LENGTH_TALLY_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "xdg/constants.h"
+#include "xdg/vec3da.h"
+
+namespace xdg {
+
+class XDG; // Forward declaration
+
+/*! Thread-parallel track-length tally over the volume elements of a mesh.
+
+    Batches of tracks (start, end, weight) are walked through the mesh in
+    parallel (one at a time if the ray tracer does not support concurrent
+    queries) and the weighted length of each segment is accumulated into a
+    dense array indexed by MeshManager::element_index. Segments are visited
+    as they are found, so no segment vectors are allocated.
+
+    Scores are accumulated either into a buffer per thread, merged into the
+    results at the end of each batch, or directly into the results with
+    atomic updates. Thread-local buffers avoid contention but need memory
+    for every element on every thread. They are kept from one batch to the
+    next, and each thread records the elements it scored so that only those
+    are merged and zeroed. In AUTO mode they are used unless that memory
+    exceeds MAX_THREAD_LOCAL_BYTES.
+
+    With compensated summation each sum carries a Neumaier correction term,
+    which keeps the result of adding many short segments to an element from
+    depending on the order of the additions. Compensation is only available
+    with thread-local buffers.
+ */
+class TrackLengthTally {
+public:
+  //! How scores from concurrent tracks are combined
+  enum class Mode {
+    AUTO,         //!< Thread-local buffers unless they would exceed MAX_THREAD_LOCAL_BYTES
+    THREAD_LOCAL, //!< A buffer per thread, merged at the end of each batch
+    ATOMIC        //!< Atomic updates of the shared results
+  };
+
+  //! Largest total size of the thread-local buffers selected in AUTO mode
+  static constexpr size_t MAX_THREAD_LOCAL_BYTES {size_t(1) << 30};
+
+  // Constructors
+  TrackLengthTally(std::shared_ptr<const XDG> xdg,
+                   Mode mode = Mode::AUTO,
+                   bool compensated = false);
+
+  //! \brief Score a batch of tracks. All arrays are contiguous and of length n_tracks.
+  //! \param n_tracks Number of tracks in the batch
+  //! \param starts Start point of each track
+  //! \param ends End point of each track
+  //! \param weights Weight of each track (a weight of one is used if nullptr)
+  void score(size_t n_tracks,
+             const Position* starts,
+             const Position* ends,
+             const double* weights = nullptr);
+
+  //! \brief Zero all scores
+  void reset();
+
+  // Accessors
+
+  //! Accumulated score of each element, indexed by MeshManager::element_index
+  std::vector<double> results() const;
+
+  //! Accumulated score of an element
+  double result(MeshID element) const;
+
+  size_t num_elements() const { return sums_.size(); }
+
+  //! Accumulation mode in use (never AUTO)
+  Mode mode() const { return mode_; }
+
+  bool compensated() const { return compensated_; }
+
+private:
+  void score_thread_local(size_t n_tracks,
+                          const Position* starts,
+                          const Position* ends,
+                          const double* weights);
+
+  void score_atomic(size_t n_tracks,
+                    const Position* starts,
+                    const Position* ends,
+                    const double* weights);
+
+  //! Scores of one thread, zero outside of score_thread_local
+  struct ThreadBuffer {
+    std::vector<double> sums; //!< Score of each element in the current batch
+    std::vector<double> compensations; //!< Correction term of each sum (empty unless compensated)
+    std::vector<MeshIndex> touched; //!< Elements scored in the current batch
+  };
+
+  std::shared_ptr<const XDG> xdg_;
+  Mode mode_;
+  bool compensated_;
+  std::vector<double> sums_; //!< Score of each element
+  std::vector<double> compensations_; //!< Correction term of each sum (empty unless compensated)
+  std::vector<ThreadBuffer> thread_buffers_; //!< Buffer of each thread, allocated by the first batch
+};
+
+} // namespace xdg
+
+#endif // include guard
@@ -0,0 +1,133 @@
+#ifndef _XDG_TREE_CACHE_H
+#define _XDG_TREE_CACHE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xdg/constants.h"
+#include "xdg/vec3da.h"
+
+namespace xdg {
+
+class MeshManager; // Forward declaration
+
+//! Read-only view of a contiguous range of IDs held by a TreeCache
+struct MeshIDSpan {
+  const MeshID* data {nullptr};
+  size_t count {0};
+
+  const MeshID* begin() const { return data; }
+  const MeshID* end() const { return data + count; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  MeshID operator[](size_t i) const { return data[i]; }
+};
+
+/*! Cache of the mesh data used to build acceleration structures.
+
+    Holds the faces of each surface in primitive order (the contents of the
+    PrimitiveRef buffers of surface trees), the vertices of those faces and
+    the elements of each volume. Ray tracers building trees from a cache do
+    not need to query the mesh library for this data, which dominates startup
+    for large models. The trees themselves (e.g. Embree BVHs) are still built
+    by the ray tracer.
+
+    A cache can be written to a versioned binary file keyed on the size and
+    modification time of the mesh file and on the tree build parameters.
+    Later processes memory map the file instead of gathering the data again
+    and check it against the loaded mesh (see matches) before using it.
+    Files are written in the native byte order and are not portable between
+    architectures.
+ */
+class TreeCache {
+public:
+  static constexpr uint32_t VERSION {2}; //!< Version of the cache file layout and key
+  static constexpr uint64_t HASH_SEED {14695981039346656037ULL}; //!< Initial value of a key
+
+  // Constructors/Destructors
+  ~TreeCache();
+
+  //! Gather the data for all surfaces and volumes of a mesh
+  static std::shared_ptr<TreeCache> from_mesh(const MeshManager& mesh_manager, uint64_t key);
+
+  //! Open a cache file. Returns nullptr if the file does not exist, was
+  //! written by a different version or has a different key.
+  static std::shared_ptr<TreeCache> open(const std::string& path, uint64_t key);
+
+  //! Check that the cache describes a mesh: the number of surfaces, faces,
+  //! volumes and elements and the first and last face of each surface must
+  //! match. This catches mesh changes the key of a cache file can miss (e.g.
+  //! a file rewritten with the same size and modification time).
+  bool matches(const MeshManager& mesh_manager) const;
+
+  //! Compute a cache key from the size and modification time of a mesh
+  //! file, the mesh library used to read it and a key of the tree build
+  //! parameters (see RayTracer::tree_build_key)
+  static uint64_t compute_key(const std::string& mesh_file, MeshLibrary mesh_library, uint64_t build_key);
+
+  //! Mix the bytes of a set of scalar values into a key (64-bit FNV-1a)
+  template<typename... T>
+  static uint64_t hash_values(uint64_t key, const T&... values)
+  {
+    (hash_bytes(key, &values, sizeof(T)), ...);
+    return key;
+  }
+
+  static void hash_bytes(uint64_t& key, const void* data, size_t size);
+
+  //! Write the cache to a file
+  void write(const std::string& path) const;
+
+  // Accessors
+  uint64_t key() const { return key_; }
+
+  size_t num_surfaces() const { return surface_index_.size(); }
+  size_t num_volumes() const { return volume_index_.size(); }
+
+  bool contains_surface(MeshID surface) const { return surface_index_.count(surface); }
+  bool contains_volume(MeshID volume) const { return volume_index_.count(volume); }
+
+  //! Faces of a surface in primitive order. The view is valid for the
+  //! lifetime of the cache.
+  MeshIDSpan surface_faces(MeshID surface) const;
+
+  //! Vertices of the i-th face of a surface
+  std::array<Vertex, 3> face_vertices(MeshID surface, size_t i) const;
+
+  //! Elements of a volume. The view is valid for the lifetime of the cache.
+  MeshIDSpan volume_elements(MeshID volume) const;
+
+private:
+  TreeCache() = default;
+
+  //! Index the surfaces and volumes of a cache image. Returns false if the
+  //! image is malformed.
+  bool parse(const char* data, size_t size);
+
+  // Location of a surface's faces or a volume's elements in the cache image
+  struct Range {
+    size_t offset;
+    size_t count;
+  };
+
+  uint64_t key_ {0};
+  size_t n_faces_ {0}; //!< Number of faces of all surfaces
+  size_t n_elements_ {0}; //!< Number of elements of all volumes
+  std::vector<char> buffer_; //!< Cache image, if held in memory
+  void* mapping_ {nullptr}; //!< Cache image, if memory mapped from a file
+  size_t mapping_size_ {0};
+
+  const MeshID* face_ids_ {nullptr}; //!< Faces of all surfaces
+  const double* face_coords_ {nullptr}; //!< Vertex coordinates of all faces (9 per face)
+  const MeshID* element_ids_ {nullptr}; //!< Elements of all volumes
+  std::unordered_map<MeshID, Range> surface_index_;
+  std::unordered_map<MeshID, Range> volume_index_;
+};
+
+} // namespace xdg
+
+#endif // include guard
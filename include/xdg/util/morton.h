@@ -0,0 +1,61 @@
+#ifndef XDG_UTIL_MORTON_H
+#define XDG_UTIL_MORTON_H
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "xdg/bbox.h"
+#include "xdg/vec3da.h"
+
+namespace xdg {
+
+// Spread the lower 21 bits of a value so that there are two zero bits
+// between each of them
+inline uint64_t morton_spread_bits(uint64_t v)
+{
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffff;
+  v = (v | v << 16) & 0x1f0000ff0000ff;
+  v = (v | v << 8)  & 0x100f00f00f00f00f;
+  v = (v | v << 4)  & 0x10c30c30c30c30c3;
+  v = (v | v << 2)  & 0x1249249249249249;
+  return v;
+}
+
+//! Returns the 63-bit Morton code of a point quantized within a bounding box
+inline uint64_t morton_code(const Position& p, const BoundingBox& box)
+{
+  constexpr double n_cells = (1 << 21) - 1;
+  Vec3da width = box.width();
+  uint64_t code {0};
+  for (int i = 0; i < 3; ++i) {
+    double t = width[i] > 0.0 ? (p[i] - box.bounds[i]) / width[i] : 0.0;
+    t = std::clamp(t, 0.0, 1.0);
+    code |= morton_spread_bits(static_cast<uint64_t>(t * n_cells)) << i;
+  }
+  return code;
+}
+
+//! Returns the indices of a set of points ordered along a Morton
+//! (Z-order) curve so that consecutive points are close in space
+inline std::vector<size_t> morton_order(size_t n_points, const Position* points)
+{
+  std::vector<size_t> order(n_points);
+  std::iota(order.begin(), order.end(), 0);
+  if (n_points == 0) return order;
+
+  BoundingBox box {INFTY, INFTY, INFTY, -INFTY, -INFTY, -INFTY};
+  for (size_t i = 0; i < n_points; ++i) box.update(points[i]);
+
+  std::vector<uint64_t> codes(n_points);
+  for (size_t i = 0; i < n_points; ++i) codes[i] = morton_code(points[i], box);
+
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return codes[a] < codes[b]; });
+  return order;
+}
+
+} // namespace xdg
+
+#endif // XDG_UTIL_MORTON_H
@@ -1,7 +1,10 @@
 #ifndef _XDG_INTERFACE_H
 #define _XDG_INTERFACE_H
 
+#include <algorithm>
 #include <memory>
+#include <shared_mutex>
+#include <string>
 #include <unordered_map>
 
 #include "xdg/mesh_manager_interface.h"
@@ -10,6 +13,34 @@
 
 namespace xdg {
 
+//! Acceleration structures built when preparing the ray tracer
+struct TreeOptions {
+  bool surface_trees {true}; //!< Surface trees of each volume (ray fire, point containment, closest)
+  bool element_trees {true}; //!< Element trees of each volume (point location)
+  bool global_trees {true}; //!< Global surface and element trees spanning all volumes
+  bool lazy {false}; //!< Build each tree on the first query that needs it instead of up front
+  bool face_planes {true}; //!< Cache the normal and plane of each face for use by the trees
+  std::string cache_file {}; //!< File caching the mesh data used to build trees (no caching if empty)
+  std::string mesh_file {}; //!< Mesh file the cache is keyed on (required if cache_file is set)
+};
+
+//! Segments of a batch of tracks in compressed sparse row form. The
+//! segments of track i are elements[j] and lengths[j] for j in
+//! [offsets[i], offsets[i + 1]).
+struct TrackSegments {
+  std::vector<size_t> offsets; //!< Start of each track's segments (n_tracks + 1 entries)
+  std::vector<MeshID> elements; //!< Element (or volume, for volume segments) of each segment
+  std::vector<double> lengths; //!< Length of each segment
+};
+
+//! A volume element with the volume containing it and the interned
+//! material of that volume (see MeshManager::volume_properties)
+struct ElementLocation {
+  MeshID element {ID_NONE}; //!< Volume element (ID_NONE if not in the mesh)
+  MeshID volume {ID_NONE}; //!< Volume containing the element
+  PropertyID material {PROPERTY_NONE}; //!< Material of the volume
+};
+
 class XDG {
 
 public:
@@ -21,20 +52,100 @@ public:
   // factory method that allows for specification of a backend mesh library and ray tracer. Default to MOAB + EMBREE
   static std::shared_ptr<XDG> create(MeshLibrary mesh_lib = MeshLibrary::MOAB, RTLibrary ray_tracing_lib = RTLibrary::EMBREE);
 
+  //! Wall-clock time spent in each phase of prepare_raytracer [s]
+  struct PrepareTimings {
+    double cache {0.0}; //!< Reading or creating the tree cache
+    double volume_trees {0.0}; //!< Surface and element trees of each volume
+    double global_trees {0.0}; //!< Global surface and element trees
+    double init {0.0}; //!< Ray tracer initialization
+    double total {0.0}; //!< All phases
+
+    //! Write the breakdown of preparation time
+    void write() const;
+  };
+
   // Methods
   void prepare_raytracer();
 
+  //! Prepare the ray tracer, building only the requested acceleration
+  //! structures. In lazy mode no trees are built here; each is built by the
+  //! first query that needs it. Queries requiring a structure that was not
+  //! requested are an error.
+  void prepare_raytracer(const TreeOptions& options);
+
   void prepare_volume_for_raytracing(MeshID volume);
 
 // Geometric Queries
+//! Determines the volume containing a point. A single ray is fired through
+//! the global surface tree and the volume is identified from the senses of
+//! the first surface hit. Falls back to testing each volume in turn if the
+//! global surface tree is unavailable or every ray hits a face tangentially.
+//! @param point Point to locate
+//! @param direction Direction of the first ray fired
+//! @param hint Volume tested before any others, e.g. the volume of a nearby point
+//! @return Volume containing the point (the implicit complement if the point
+//! is not in any other volume)
 MeshID find_volume(const Position& point,
-                   const Direction& direction) const;
+                   const Direction& direction,
+                   MeshID hint = ID_NONE) const;
+
+//! Determines the volume containing each point in a batch. All arrays are
+//! contiguous and of length n_points. Points are located in parallel with
+//! rays through the global surface tree as in find_volume; points that
+//! cannot be resolved that way are tested against each volume in turn.
+//! @param n_points Number of points in the batch
+//! @param points Points to locate
+//! @param directions Direction of the containment ray for each point (may be nullptr)
+//! @param volumes Output volume containing each point (the implicit
+//! complement if the point is not in any other volume)
+void find_volume_batch(size_t n_points,
+                       const Position* points,
+                       const Direction* directions,
+                       MeshID* volumes) const;
 
 MeshID find_element(const Position& point) const;
 
 MeshID find_element(MeshID volume,
                     const Position& point) const;
 
+//! Locates the elements containing a batch of points using the global element tree
+//! @param n_points Number of points in the batch
+//! @param points Points to locate
+//! @param elements Output element containing each point (ID_NONE on a miss)
+//! @param missed Output flag set for each point that is not in any element (may be nullptr)
+//! @return The number of points that are not in any element
+size_t find_element_batch(size_t n_points,
+                          const Position* points,
+                          MeshID* elements,
+                          bool* missed = nullptr) const;
+
+//! Locates the elements containing a batch of points within a volume
+size_t find_element_batch(MeshID volume,
+                          size_t n_points,
+                          const Position* points,
+                          MeshID* elements,
+                          bool* missed = nullptr) const;
+
+//! Returns the volume and material of a volume element, read from the
+//! volume and property tables
+ElementLocation element_location(MeshID element) const;
+
+//! Locates the element containing a point using the global element tree,
+//! along with its volume and material
+//! @param point The point to locate
+//! @return The element, volume and material (all unset if the point
+//! is not in any element)
+ElementLocation locate_element(const Position& point) const;
+
+//! Returns the segments between the start and end points on the mesh along
+//! with the volume and material of each element
+//! @param start The starting point of the query
+//! @param end The ending point of the query
+//! @return A vector of pairs containing the element location and length inside each element
+std::vector<std::pair<ElementLocation, double>>
+located_segments(const Position& start,
+                 const Position& end) const;
+
 //! Returns a vector of segments between the start and end points on the mesh
 //! @param start The starting point of the query
 //! @param end The ending point of the query
@@ -53,6 +164,78 @@ segments(MeshID volume,
          const Position& start,
          const Position& end) const;
 
+//! Returns the segments of a batch of tracks on the mesh, computed in
+//! parallel if the ray tracer supports concurrent queries (Embree) and one
+//! track at a time otherwise (GPRT). All arrays are contiguous and of
+//! length n_tracks.
+//! @param n_tracks Number of tracks in the batch
+//! @param starts The starting point of each track
+//! @param ends The ending point of each track
+//! @return The segments of all tracks, in track order
+TrackSegments segments_batch(size_t n_tracks,
+                             const Position* starts,
+                             const Position* ends) const;
+
+//! Visits the segments between the start and end points on the mesh as they
+//! are found, without collecting them
+//! @param start The starting point of the query
+//! @param end The ending point of the query
+//! @param visitor Callable invoked as visitor(element, length) for each
+//! segment in order along the track. The query stops early if it returns false.
+//! It is called without any internal lock held and may make other XDG queries.
+template<typename Visitor>
+void segments(const Position& start,
+              const Position& end,
+              Visitor&& visitor) const;
+
+//! Visits the segments between the start and end points on the mesh for a
+//! specified volume (subdomain) as they are found, without collecting them
+//! @param volume The ID of the volume to intersect with
+//! @param start The starting point of the query
+//! @param end The ending point of the query
+//! @param visitor Callable invoked as visitor(element, length) for each
+//! segment in order along the track. The query stops early if it returns false.
+//! It is called without any internal lock held and may make other XDG queries.
+template<typename Visitor>
+void segments(MeshID volume,
+              const Position& start,
+              const Position& end,
+              Visitor&& visitor) const;
+
+//! Returns the volumes crossed between the start and end points and the
+//! length of the track in each, found by firing rays against the surfaces
+//! of each volume in turn. No volume elements are walked.
+//! @param start The starting point of the query
+//! @param end The ending point of the query
+//! @return A vector of pairs containing the volume ID and length inside each volume
+std::vector<std::pair<MeshID, double>>
+volume_segments(const Position& start,
+                const Position& end) const;
+
+//! Returns the volume segments of a batch of tracks, computed in parallel
+//! if the ray tracer supports concurrent queries (Embree) and one track at
+//! a time otherwise (GPRT). All arrays are contiguous and of length n_tracks.
+//! @param n_tracks Number of tracks in the batch
+//! @param starts The starting point of each track
+//! @param ends The ending point of each track
+//! @return The volume segments of all tracks, in track order
+TrackSegments volume_segments_batch(size_t n_tracks,
+                                    const Position* starts,
+                                    const Position* ends) const;
+
+//! Visits the volumes crossed between the start and end points as they are found
+//! @param volume The volume containing the start point
+//! @param start The starting point of the query
+//! @param end The ending point of the query
+//! @param visitor Callable invoked as visitor(volume, length) for each
+//! segment in order along the track. The query stops early if it returns false.
+//! It is called without any internal lock held and may make other XDG queries.
+template<typename Visitor>
+void volume_segments(MeshID volume,
+                     const Position& start,
+                     const Position& end,
+                     Visitor&& visitor) const;
+
 //! Returns the next element along a line
 //! @param current_element The current element
 //! @param r The starting point of the line
@@ -68,6 +251,30 @@ bool point_in_volume(MeshID volume,
       const Direction* direction = nullptr,
       const std::vector<MeshID>* exclude_primitives = nullptr) const;
 
+//! Determines whether a point lies inside a volume, ignoring the primitives
+//! recorded in a ray history
+//! @param volume The volume to test against
+//! @param point The point to test
+//! @param direction Direction of the containment ray (may be nullptr)
+//! @param history Recently crossed primitives to exclude (may be nullptr)
+bool point_in_volume_with_history(MeshID volume,
+      const Position point,
+      const Direction* direction,
+      const RayHistory* history) const;
+
+//! Determines whether each point in a batch lies inside a volume. All
+//! arrays are contiguous and of length n_points.
+//! @param volume The volume to test against
+//! @param n_points Number of points in the batch
+//! @param points Points to test
+//! @param directions Direction of the containment ray for each point (may be nullptr)
+//! @param results Output containment of each point (INSIDE or OUTSIDE)
+void point_in_volume_batch(MeshID volume,
+                           size_t n_points,
+                           const Position* points,
+                           const Direction* directions,
+                           PointInVolume* results) const;
+
 std::pair<double, MeshID> ray_fire(MeshID volume,
                                    const Position& origin,
                                    const Direction& direction,
@@ -75,6 +282,41 @@ std::pair<double, MeshID> ray_fire(MeshID volume,
                                    HitOrientation orientation = HitOrientation::EXITING,
                                    std::vector<MeshID>* const exclude_primitives = nullptr) const;
 
+//! Fires a ray in a volume, ignoring the primitives recorded in a ray
+//! history. The primitive hit, if any, is added to the history.
+//! @param volume The volume to fire the ray in
+//! @param origin The ray origin
+//! @param direction The ray direction
+//! @param dist_limit Maximum distance of the ray
+//! @param orientation Hit orientation to accept
+//! @param history Recently crossed primitives to exclude (may be nullptr)
+//! @return A pair containing the distance to the hit and the surface hit
+std::pair<double, MeshID> ray_fire_with_history(MeshID volume,
+                                                const Position& origin,
+                                                const Direction& direction,
+                                                const double dist_limit,
+                                                HitOrientation orientation,
+                                                RayHistory* history) const;
+
+//! Fires a batch of rays, each against its own volume. All arrays are
+//! contiguous and of length n_rays.
+//! @param n_rays Number of rays in the batch
+//! @param volumes Volume to fire each ray in
+//! @param origins Ray origins
+//! @param directions Ray directions
+//! @param dist_limits Maximum distance of each ray (may be nullptr for no limit)
+//! @param distances Output distance to the hit for each ray (INFTY on a miss)
+//! @param surfaces Output surface hit by each ray (ID_NONE on a miss)
+//! @param orientation Hit orientation to accept for all rays in the batch
+void ray_fire_batch(size_t n_rays,
+                    const MeshID* volumes,
+                    const Position* origins,
+                    const Direction* directions,
+                    const double* dist_limits,
+                    double* distances,
+                    MeshID* surfaces,
+                    HitOrientation orientation = HitOrientation::EXITING) const;
+
 std::pair<double, MeshID> closest(MeshID volume,
                                   const Position& origin) const;
 
@@ -90,6 +332,12 @@ Direction surface_normal(MeshID surface,
                          Position point,
                          const std::vector<MeshID>* exclude_primitives = nullptr) const;
 
+//! Returns the normal of a surface at a point, using the most recently
+//! crossed primitive in the history if there is one
+Direction surface_normal_with_history(MeshID surface,
+                                      Position point,
+                                      const RayHistory* history) const;
+
 
   // Geometric Measurements
   double measure_volume(MeshID volume) const;
@@ -113,8 +361,67 @@ Direction surface_normal(MeshID surface,
   const std::shared_ptr<MeshManager>& mesh_manager() const {
     return mesh_manager_;
   }
+
+  //! Time spent in each phase of the last call to prepare_raytracer
+  const PrepareTimings& prepare_timings() const {
+    return prepare_timings_;
+  }
 // Private methods
 private:
+  using TreeLock = std::shared_lock<std::shared_mutex>;
+
+  //! Lock held by queries while trees may still be built on demand. Does not
+  //! lock anything unless the ray tracer was prepared in lazy mode.
+  TreeLock lock_trees() const;
+
+  //! Release a tree lock while user code runs, so that visitors may call back
+  //! into XDG (including queries that build trees on demand)
+  static void release_trees(TreeLock& lock) { if (lock.owns_lock()) lock.unlock(); }
+
+  //! Reacquire a tree lock released by release_trees
+  static void reacquire_trees(TreeLock& lock) { if (lock.mutex() && !lock.owns_lock()) lock.lock(); }
+
+  //! Surface tree of a volume, built first if needed in lazy mode
+  TreeID surface_tree(MeshID volume, TreeLock& lock) const;
+
+  //! Element tree of a volume, built first if needed in lazy mode
+  TreeID element_tree(MeshID volume, TreeLock& lock) const;
+
+  //! Ensure the surface trees of all volumes exist
+  void require_surface_trees(TreeLock& lock) const;
+
+  //! Ensure the global surface tree exists if it was requested
+  void require_global_surface_tree(TreeLock& lock) const;
+
+  //! Ensure the global element tree exists
+  void require_global_element_tree(TreeLock& lock) const;
+
+  //! Find the element a track continues in, entering the mesh through the
+  //! implicit complement if the track position is outside of it. Moves the
+  //! position and reduces the remaining distance up to the entry point.
+  //! Returns ID_NONE if the track does not reach another element.
+  MeshID track_start_element(Position& r,
+                             const Direction& u,
+                             double& distance,
+                             MeshID last_element,
+                             RayHistory& history,
+                             TreeLock& lock) const;
+
+  //! Find the element a track starts in within a volume, moving the position
+  //! up to the volume boundary if the track starts outside of the volume.
+  //! Returns ID_NONE if the track does not enter the volume.
+  MeshID volume_track_start_element(MeshID volume,
+                                    Position& r,
+                                    const Direction& u,
+                                    TreeLock& lock) const;
+
+  //! Run a tree build while holding the lock exclusively
+  template<typename Build>
+  void build_on_demand(TreeLock& lock, Build build) const;
+
+  //! Whether a missing tree of the given kind may be built on demand
+  bool builds_on_demand(bool requested) const;
+
   double _triangle_volume_contribution(const PrimitiveRef& triangle) const;
   double _triangle_area_contribution(const PrimitiveRef& triangle) const;
 
@@ -122,12 +429,106 @@ private:
   std::shared_ptr<RayTracer> ray_tracing_interface_ {nullptr};
   std::shared_ptr<MeshManager> mesh_manager_ {nullptr};
 
-  std::unordered_map<MeshID, TreeID> volume_to_surface_tree_map_;  //<! Map from mesh volume to raytracing tree
+  mutable std::unordered_map<MeshID, TreeID> volume_to_surface_tree_map_;  //<! Map from mesh volume to raytracing tree
   std::unordered_map<MeshID, TreeID> surface_to_tree_map_; //<! Map from mesh surface to embree scnee
-  std::unordered_map<MeshID, TreeID> volume_to_point_location_tree_map_; //<! Map from mesh volume to embree point location tree
+  mutable std::unordered_map<MeshID, TreeID> volume_to_point_location_tree_map_; //<! Map from mesh volume to embree point location tree
+  mutable bool global_surface_tree_built_ {false}; //<! Whether the global surface tree has been built
+  mutable bool global_element_tree_built_ {false}; //<! Whether the global element tree has been built
+  TreeOptions tree_options_; //<! Acceleration structures requested when preparing the ray tracer
+  mutable std::shared_mutex tree_mutex_; //<! Guards on-demand tree construction in lazy mode
+  PrepareTimings prepare_timings_; //<! Timing breakdown of prepare_raytracer
   TreeID global_scene_; // TODO: does this need to be in the RayTacer class or the XDG? class
 };
 
+template<typename Visitor>
+void XDG::segments(const Position& start,
+                   const Position& end,
+                   Visitor&& visitor) const
+{
+  Position r = start;
+  Direction u = end - start;
+  double distance = u.length();
+  u /= distance;
+
+  RayHistory hit_primitives;
+
+  auto lock = lock_trees();
+  require_global_element_tree(lock);
+
+  MeshID last_element = ID_NONE;
+  bool stopped = false;
+  auto visit = [&](MeshID element, double length) {
+    last_element = element;
+    // decrement the distance by each segment in the same order as the walk
+    // so that it reaches zero exactly when the walk reaches the end point
+    distance -= length;
+    stopped = !visitor(element, length);
+    return !stopped;
+  };
+
+  while (distance > 0 && !stopped) {
+    reacquire_trees(lock);
+    MeshID current_element = track_start_element(r, u, distance, last_element, hit_primitives, lock);
+    if (current_element == ID_NONE) return;
+    // the element walk reads no trees, so the visitor runs without the lock
+    release_trees(lock);
+    double traveled = mesh_manager()->walk_elements(current_element, r, u, distance, visit);
+    // upate location of the track start
+    r += u * traveled;
+  }
+}
+
+template<typename Visitor>
+void XDG::segments(MeshID volume,
+                   const Position& start,
+                   const Position& end,
+                   Visitor&& visitor) const
+{
+  Position r = start;
+  Direction u = (end - start).normalize();
+  auto lock = lock_trees();
+  MeshID starting_element = volume_track_start_element(volume, r, u, lock);
+  if (starting_element == ID_NONE) return;
+  // the element walk reads no trees, so the visitor runs without the lock
+  release_trees(lock);
+  mesh_manager()->walk_elements(starting_element, r, u, (end - r).length(), visitor);
+}
+
+template<typename Visitor>
+void XDG::volume_segments(MeshID volume,
+                          const Position& start,
+                          const Position& end,
+                          Visitor&& visitor) const
+{
+  Position r = start;
+  Direction u = end - start;
+  double distance = u.length();
+  if (distance == 0.0) return;
+  u /= distance;
+
+  // every surface crossed is kept in the history so that it is not hit again
+  RayHistory history;
+
+  auto lock = lock_trees();
+  while (distance > 0.0 && volume != ID_NONE) {
+    reacquire_trees(lock);
+    auto hit = ray_tracing_interface()->ray_fire_with_history(surface_tree(volume, lock), r, u, distance, HitOrientation::EXITING, &history);
+    // the visitor runs without the lock
+    release_trees(lock);
+    // the track ends within this volume
+    if (hit.second == ID_NONE) {
+      visitor(volume, distance);
+      return;
+    }
+
+    double length = std::min(hit.first, distance);
+    distance -= length;
+    if (!visitor(volume, length)) return;
+    r += u * length;
+    volume = mesh_manager()->next_volume(volume, hit.second);
+  }
+}
+
 }
 
 
@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
 #include "xdg/embree/ray_tracer.h"
 #include "xdg/error.h"
 #include "xdg/geometry_data.h"
 #include "xdg/ray.h"
 #include "xdg/tetrahedron_contain.h"
+#include "xdg/util/morton.h"
 
 
 namespace xdg {
@@ -46,9 +52,52 @@ EmbreeRayTracer::register_volume(const std::shared_ptr<MeshManager>& mesh_manage
   return {faces_tree, element_tree};
 }
 
+std::vector<std::pair<TreeID, TreeID>>
+EmbreeRayTracer::register_volumes(const std::shared_ptr<MeshManager>& mesh_manager,
+                                  const std::vector<MeshID>& volumes)
+{
+  // Geometry creation and the bookkeeping for surfaces shared between
+  // volumes are done serially. Only the scene commits (BVH builds) are
+  // deferred as these are independent of one another once every geometry
+  // has been created.
+  std::vector<std::pair<TreeID, TreeID>> trees(volumes.size());
+  std::vector<RTCScene> scenes;
+  for (size_t i = 0; i < volumes.size(); ++i) {
+    trees[i].first = create_surface_scene(mesh_manager, volumes[i]);
+    scenes.push_back(surface_volume_tree_to_scene_map_.at(trees[i].first));
+    trees[i].second = create_element_scene(mesh_manager, volumes[i]);
+    if (trees[i].second != TREE_NONE)
+      scenes.push_back(element_volume_tree_to_scene_map_.at(trees[i].second));
+  }
+
+  commit_scenes(scenes);
+  return trees;
+}
+
+void EmbreeRayTracer::commit_scenes(const std::vector<RTCScene>& scenes)
+{
+  // Embree parallelizes the build of a single scene internally, but most
+  // volume scenes are too small to benefit from this. Building many scenes at
+  // once keeps all threads busy. Scene sizes vary widely, hence the dynamic
+  // schedule.
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t i = 0; i < scenes.size(); ++i) {
+    rtcCommitScene(scenes[i]);
+  }
+}
+
 SurfaceTreeID
 EmbreeRayTracer::create_surface_tree(const std::shared_ptr<MeshManager>& mesh_manager,
                            MeshID volume_id)
+{
+  SurfaceTreeID tree = create_surface_scene(mesh_manager, volume_id);
+  rtcCommitScene(surface_volume_tree_to_scene_map_.at(tree));
+  return tree;
+}
+
+SurfaceTreeID
+EmbreeRayTracer::create_surface_scene(const std::shared_ptr<MeshManager>& mesh_manager,
+                                      MeshID volume_id)
 {
   SurfaceTreeID tree = next_surface_tree_id();
   surface_trees_.push_back(tree);
@@ -59,13 +108,17 @@ EmbreeRayTracer::create_surface_tree(const std::shared_ptr<MeshManager>& mesh_ma
   size_t vol_face_count = 0;
   for (auto& surface_id : volume_surfaces) {
     if (!surface_to_geometry_map_.count(surface_id)) {
-      vol_face_count += mesh_manager->get_surface_faces(surface_id).size();
+      if (tree_cache_ && tree_cache_->contains_surface(surface_id))
+        vol_face_count += tree_cache_->surface_faces(surface_id).size();
+      else
+        vol_face_count += mesh_manager->get_surface_faces(surface_id).size();
     }
   }
 
   this->primitive_ref_storage_[volume_scene].resize(vol_face_count);
   auto& triangle_storage = this->primitive_ref_storage_[volume_scene];
   PrimitiveRef* tri_ref_ptr = triangle_storage.data();
+  if (cache_triangle_vertices_) this->vertex_storage_[volume_scene].resize(vol_face_count);
   auto bump = bounding_box_bump(mesh_manager, volume_id);
   int storage_offset = 0;
 
@@ -99,7 +152,6 @@ EmbreeRayTracer::create_surface_tree(const std::shared_ptr<MeshManager>& mesh_ma
     }
   }
 
-  rtcCommitScene(volume_scene);
   surface_volume_tree_to_scene_map_[tree] = volume_scene;
   return tree;
 }
@@ -112,33 +164,78 @@ EmbreeRayTracer::register_surface(const std::shared_ptr<MeshManager>& mesh_manag
 {
   auto& triangle_storage = this->primitive_ref_storage_[volume_scene];
   PrimitiveRef* tri_ref_ptr = triangle_storage.data();
-  auto surface_faces = mesh_manager->get_surface_faces(surface);
+  // read the faces and vertices from the tree cache when available
+  bool cached = tree_cache_ && tree_cache_->contains_surface(surface);
+  std::vector<MeshID> mesh_faces;
+  if (!cached) mesh_faces = mesh_manager->get_surface_faces(surface);
+  MeshIDSpan surface_faces = cached ? tree_cache_->surface_faces(surface) : MeshIDSpan {mesh_faces.data(), mesh_faces.size()};
   size_t surf_face_count = surface_faces.size();
+  auto face_vertices = [&](size_t i) {
+    return cached ? tree_cache_->face_vertices(surface, i) : mesh_manager->face_vertices(surface_faces[i]);
+  };
 
   // fill primitive refs
   for (size_t i = 0; i < surf_face_count; ++i) {
     triangle_storage[storage_offset + i].primitive_id = surface_faces[i];
   }
 
-  // create new RTCGeometry for the surface
-  auto surface_geometry = rtcNewGeometry(device_, RTC_GEOMETRY_TYPE_USER);
-  rtcSetGeometryUserPrimitiveCount(surface_geometry, surf_face_count);
-  rtcAttachGeometry(volume_scene, surface_geometry);
-  surface_to_geometry_map_[surface] = surface_geometry;
+  // fill the vertex cache (if enabled) in the same order as the primitive refs
+  std::array<Vertex, 3>* vertex_ptr {nullptr};
+  if (cache_triangle_vertices_) {
+    vertex_ptr = this->vertex_storage_[volume_scene].data() + storage_offset;
+    for (size_t i = 0; i < surf_face_count; ++i) {
+      vertex_ptr[i] = face_vertices(i);
+    }
+  }
+
+  // read the planes (if enabled) from the mesh manager's face plane cache,
+  // which stores the planes of a surface in the same order as the primitive refs
+  const FacePlane* plane_ptr = cache_face_planes_ ? mesh_manager->surface_face_planes(surface) : nullptr;
 
   // create new SurfaceUserData for the surface
   auto surface_data = std::make_shared<SurfaceUserData>();
   surface_data->surface_id = surface;
   surface_data->mesh_manager = mesh_manager.get();
   surface_data->prim_ref_buffer = tri_ref_ptr + storage_offset;
-  surface_user_data_map_[surface_geometry] = surface_data;
-  rtcSetGeometryUserData(surface_geometry, surface_data.get());
+  surface_data->vertex_buffer = vertex_ptr;
+  surface_data->plane_buffer = plane_ptr;
 
-  // Set RTC callbacks
-  rtcSetGeometryBoundsFunction(surface_geometry, (RTCBoundsFunction)&TriangleBoundsFunc, nullptr);
-  rtcSetGeometryIntersectFunction(surface_geometry, (RTCIntersectFunctionN)&TriangleIntersectionFunc);
-  rtcSetGeometryOccludedFunction(surface_geometry, (RTCOccludedFunctionN)&TriangleOcclusionFunc);
+  // create new RTCGeometry for the surface
+  RTCGeometry surface_geometry;
+  if (surface_mode_ == EmbreeSurfaceMode::TRIANGLE && surf_face_count > 0) {
+    surface_geometry = rtcNewGeometry(device_, RTC_GEOMETRY_TYPE_TRIANGLE);
+    // triangles are stored unindexed (three vertices per triangle) in
+    // primitive order so that Embree primitive IDs match the primitive refs
+    float* vertex_buffer = (float*)rtcSetNewGeometryBuffer(surface_geometry, RTC_BUFFER_TYPE_VERTEX, 0,
+                                                           RTC_FORMAT_FLOAT3, 3 * sizeof(float), 3 * surf_face_count);
+    unsigned int* index_buffer = (unsigned int*)rtcSetNewGeometryBuffer(surface_geometry, RTC_BUFFER_TYPE_INDEX, 0,
+                                                                        RTC_FORMAT_UINT3, 3 * sizeof(unsigned int), surf_face_count);
+    for (size_t i = 0; i < surf_face_count; ++i) {
+      auto vertices = vertex_ptr ? vertex_ptr[i] : face_vertices(i);
+      for (int j = 0; j < 3; ++j) {
+        vertex_buffer[9 * i + 3 * j] = vertices[j].x;
+        vertex_buffer[9 * i + 3 * j + 1] = vertices[j].y;
+        vertex_buffer[9 * i + 3 * j + 2] = vertices[j].z;
+        index_buffer[3 * i + j] = 3 * i + j;
+      }
+    }
+    rtcSetGeometryUserData(surface_geometry, surface_data.get());
+    // hits reported by Embree are verified and refined in double precision
+    rtcSetGeometryIntersectFilterFunction(surface_geometry, (RTCFilterFunctionN)&TriangleIntersectionFilterFunc);
+  } else {
+    surface_geometry = rtcNewGeometry(device_, RTC_GEOMETRY_TYPE_USER);
+    rtcSetGeometryUserPrimitiveCount(surface_geometry, surf_face_count);
+    rtcSetGeometryUserData(surface_geometry, surface_data.get());
+
+    // Set RTC callbacks
+    rtcSetGeometryBoundsFunction(surface_geometry, (RTCBoundsFunction)&TriangleBoundsFunc, nullptr);
+    rtcSetGeometryIntersectFunction(surface_geometry, (RTCIntersectFunctionN)&TriangleIntersectionFunc);
+    rtcSetGeometryOccludedFunction(surface_geometry, (RTCOccludedFunctionN)&TriangleOcclusionFunc);
+  }
   rtcCommitGeometry(surface_geometry);
+  rtcAttachGeometry(volume_scene, surface_geometry);
+  surface_to_geometry_map_[surface] = surface_geometry;
+  surface_user_data_map_[surface_geometry] = surface_data;
 
   // increment storage offset by number of faces in this surface
   storage_offset += surf_face_count;
@@ -146,11 +243,54 @@ EmbreeRayTracer::register_surface(const std::shared_ptr<MeshManager>& mesh_manag
   return {surface_geometry, surface_data};
 }
 
+void EmbreeRayTracer::set_surface_mode(EmbreeSurfaceMode mode)
+{
+  if (!surface_trees_.empty())
+    fatal_error("The Embree surface mode must be set before any surface trees are created");
+  surface_mode_ = mode;
+}
+
+uint64_t EmbreeRayTracer::tree_build_key() const
+{
+  return TreeCache::hash_values(RayTracer::tree_build_key(), surface_mode_, cache_triangle_vertices_,
+                                cache_face_planes_, cache_tet_transforms_);
+}
+
+size_t EmbreeRayTracer::triangle_vertex_cache_size() const
+{
+  size_t n_bytes = 0;
+  for (const auto& [scene, vertices] : vertex_storage_) {
+    n_bytes += vertices.capacity() * sizeof(std::array<Vertex, 3>);
+  }
+  return n_bytes;
+}
+
+size_t EmbreeRayTracer::tet_transform_cache_size() const
+{
+  size_t n_bytes = 0;
+  for (const auto& [scene, transforms] : transform_storage_) {
+    n_bytes += transforms.capacity() * sizeof(TetTransform);
+  }
+  return n_bytes;
+}
+
 ElementTreeID
 EmbreeRayTracer::create_element_tree(const std::shared_ptr<MeshManager>& mesh_manager,
                                      MeshID volume)
 {
-  auto volume_elements = mesh_manager->get_volume_elements(volume);
+  ElementTreeID tree = create_element_scene(mesh_manager, volume);
+  if (tree != TREE_NONE) rtcCommitScene(element_volume_tree_to_scene_map_.at(tree));
+  return tree;
+}
+
+ElementTreeID
+EmbreeRayTracer::create_element_scene(const std::shared_ptr<MeshManager>& mesh_manager,
+                                      MeshID volume)
+{
+  bool cached = tree_cache_ && tree_cache_->contains_volume(volume);
+  std::vector<MeshID> mesh_elements;
+  if (!cached) mesh_elements = mesh_manager->get_volume_elements(volume);
+  MeshIDSpan volume_elements = cached ? tree_cache_->volume_elements(volume) : MeshIDSpan {mesh_elements.data(), mesh_elements.size()};
   if (volume_elements.size() == 0) return TREE_NONE;
 
   // create a new geometry
@@ -163,6 +303,24 @@ EmbreeRayTracer::create_element_tree(const std::shared_ptr<MeshManager>& mesh_ma
     primitive_ref.primitive_id = volume_elements[i];
   }
 
+  // compute the bounds of all elements up front for the bounds callback,
+  // they are reused when the geometry is attached to the global element tree
+  auto& element_bounds = this->bounds_storage_[volume_element_scene];
+  element_bounds = mesh_manager->element_bounding_boxes(volume_elements.data, volume_elements.size());
+
+  // fill the transform cache (if enabled) in the same order as the primitive refs
+  TetTransform* transform_ptr {nullptr};
+  if (cache_tet_transforms_) {
+    auto& transforms = this->transform_storage_[volume_element_scene];
+    transforms.resize(volume_elements.size());
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < volume_elements.size(); ++i) {
+      auto vertices = mesh_manager->tet_vertices(volume_elements[i]);
+      transforms[i] = tet_transform(vertices[0], vertices[1], vertices[2], vertices[3]);
+    }
+    transform_ptr = transforms.data();
+  }
+
   RTCGeometry element_geometry = rtcNewGeometry(device_, RTC_GEOMETRY_TYPE_USER);
   rtcSetGeometryUserPrimitiveCount(element_geometry, volume_elements.size());
   unsigned int embree_geometry = rtcAttachGeometry(volume_element_scene, element_geometry);
@@ -170,6 +328,8 @@ EmbreeRayTracer::create_element_tree(const std::shared_ptr<MeshManager>& mesh_ma
   volume_elements_data->volume_id = volume;
   volume_elements_data->mesh_manager = mesh_manager.get();
   volume_elements_data->prim_ref_buffer = volume_element_storage.data();
+  volume_elements_data->bounds_buffer = element_bounds.data();
+  volume_elements_data->transform_buffer = transform_ptr;
   this->volume_user_data_map_[element_geometry] = volume_elements_data;
 
   rtcSetGeometryUserData(element_geometry, volume_elements_data.get());
@@ -179,7 +339,6 @@ EmbreeRayTracer::create_element_tree(const std::shared_ptr<MeshManager>& mesh_ma
   rtcSetGeometryOccludedFunction(element_geometry, (RTCOccludedFunctionN)&TetrahedronOcclusionFunc);
 
   rtcCommitGeometry(element_geometry);
-  rtcCommitScene(volume_element_scene);
 
   ElementTreeID tree = next_element_tree_id();
   element_trees_.push_back(tree);
@@ -188,6 +347,25 @@ EmbreeRayTracer::create_element_tree(const std::shared_ptr<MeshManager>& mesh_ma
 }
 
 void EmbreeRayTracer::create_global_surface_tree()
+{
+  create_global_surface_scene();
+  rtcCommitScene(global_surface_scene_);
+}
+
+void EmbreeRayTracer::create_global_element_tree()
+{
+  create_global_element_scene();
+  rtcCommitScene(global_element_scene_);
+}
+
+void EmbreeRayTracer::create_global_trees()
+{
+  create_global_element_scene();
+  create_global_surface_scene();
+  commit_scenes({global_element_scene_, global_surface_scene_});
+}
+
+void EmbreeRayTracer::create_global_surface_scene()
 {
   if (global_surface_scene_ != nullptr) {
     rtcReleaseScene(global_surface_scene_);
@@ -198,14 +376,13 @@ void EmbreeRayTracer::create_global_surface_tree()
       rtcAttachGeometry(global_surface_scene_, geom);
   }
 
-  rtcCommitScene(global_surface_scene_);
   SurfaceTreeID tree = next_surface_tree_id();
   surface_trees_.push_back(tree);
   surface_volume_tree_to_scene_map_[tree] = global_surface_scene_;
   global_surface_tree_ = tree;
 }
 
-void EmbreeRayTracer::create_global_element_tree()
+void EmbreeRayTracer::create_global_element_scene()
 {
   if (global_element_scene_ != nullptr) {
     rtcReleaseScene(global_element_scene_);
@@ -215,7 +392,6 @@ void EmbreeRayTracer::create_global_element_tree()
   for (auto& [vol_geom, data] : volume_user_data_map_) {
     rtcAttachGeometry(global_element_scene_, vol_geom);
   }
-  rtcCommitScene(global_element_scene_);
 
   ElementTreeID tree = next_element_tree_id();
   element_trees_.push_back(tree);
@@ -238,8 +414,11 @@ MeshID EmbreeRayTracer::find_element(ElementTreeID tree,
     return ID_NONE;
   }
 
-  RTCScene scene = element_volume_tree_to_scene_map_.at(tree);
+  return locate_element(element_volume_tree_to_scene_map_.at(tree), point);
+}
 
+MeshID EmbreeRayTracer::locate_element(RTCScene scene, const Position& point) const
+{
   RTCElementDualRay ray;
   ray.set_org(point);
   ray.set_dir({1.0, 0.0, 0.0});
@@ -256,27 +435,104 @@ MeshID EmbreeRayTracer::find_element(ElementTreeID tree,
   return ray.element;
 }
 
-bool EmbreeRayTracer::point_in_volume(SurfaceTreeID tree,
-                                const Position& point,
-                                const Direction* direction,
-                                const std::vector<MeshID>* exclude_primitives) const
+size_t EmbreeRayTracer::find_element_batch(size_t n_points,
+                                           const Position* points,
+                                           MeshID* elements,
+                                           bool* missed) const
+{
+  return find_element_batch(global_element_tree_, n_points, points, elements, missed);
+}
+
+size_t EmbreeRayTracer::find_element_batch(ElementTreeID tree,
+                                           size_t n_points,
+                                           const Position* points,
+                                           MeshID* elements,
+                                           bool* missed) const
+{
+  if (!element_volume_tree_to_scene_map_.count(tree)) {
+    warning(fmt::format("Tree {} does not have a point location tree", tree));
+    std::fill(elements, elements + n_points, ID_NONE);
+    if (missed) std::fill(missed, missed + n_points, true);
+    return n_points;
+  }
+
+  RTCScene scene = element_volume_tree_to_scene_map_.at(tree);
+
+  // Visit the points along a Morton curve. Each thread receives a contiguous
+  // chunk of the ordering so that consecutive queries on a thread are close in
+  // space and traverse the same parts of the tree.
+  auto order = morton_order(n_points, points);
+
+  size_t n_missed = 0;
+  #pragma omp parallel for schedule(static) reduction(+:n_missed)
+  for (size_t k = 0; k < n_points; ++k) {
+    size_t i = order[k];
+    elements[i] = locate_element(scene, points[i]);
+    if (elements[i] == ID_NONE) n_missed++;
+    if (missed) missed[i] = elements[i] == ID_NONE;
+  }
+  return n_missed;
+}
+
+void EmbreeRayTracer::intersect(RTCScene scene, RTCDualRayHit& rayhit) const
+{
+  if (surface_mode_ == EmbreeSurfaceMode::USER) {
+    rtcIntersect1(scene, (RTCRayHit*)&rayhit);
+    return;
+  }
+
+  // Native triangle geometries are traversed with a plain single precision
+  // ray. The double precision ray/hit is passed through the query context and
+  // resolved by the geometry filter function.
+  RTCRayHit float_rayhit;
+  float_rayhit.ray = rayhit.ray;
+  // make sure hits right at the distance limit aren't lost to rounding
+  if (rayhit.ray.dtfar < INFTYF)
+    float_rayhit.ray.tfar = std::nextafter(float_rayhit.ray.tfar, std::numeric_limits<float>::max());
+  float_rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+  float_rayhit.hit.primID = RTC_INVALID_GEOMETRY_ID;
+
+  RTCDualRayQueryContext context;
+  rtcInitRayQueryContext(&context.context);
+  context.rayhit = &rayhit;
+
+  rtcIntersect1(scene, &float_rayhit, &context.context);
+}
+
+RTCDualRayHit EmbreeRayTracer::fire_surface_ray(SurfaceTreeID tree,
+                                                const Position& origin,
+                                                const Direction& direction,
+                                                double dist_limit,
+                                                HitOrientation orientation,
+                                                const std::vector<MeshID>* exclude_primitives,
+                                                const RayHistory* history) const
 {
   RTCScene scene = surface_volume_tree_to_scene_map_.at(tree);
   RTCDualRayHit rayhit; // embree specfic rayhit struct (payload?)
-  rayhit.ray.set_org(point);
-  if (direction != nullptr) rayhit.ray.set_dir(*direction);
-  else rayhit.ray.set_dir({1. / std::sqrt(2.0), 1 / std::sqrt(2.0), 0.0});
-  rayhit.ray.rf_type = RayFireType::VOLUME;
-  rayhit.ray.orientation = HitOrientation::ANY;
-  rayhit.ray.set_tfar(INFTY);
+  // set ray data
+  rayhit.ray.set_org(origin);
+  rayhit.ray.set_dir(direction);
+  rayhit.ray.set_tfar(dist_limit);
   rayhit.ray.set_tnear(0.0);
+  rayhit.ray.rf_type = RayFireType::VOLUME;
+  rayhit.ray.orientation = orientation;
+  rayhit.ray.mask = -1; // no mask
   rayhit.ray.volume_tree = tree;
+  rayhit.ray.exclude_primitives = exclude_primitives;
+  rayhit.ray.history = history;
 
-  if (exclude_primitives != nullptr) rayhit.ray.exclude_primitives = exclude_primitives;
+  // fire the ray
+  intersect(scene, rayhit);
+  return rayhit;
+}
 
-  {
-    rtcIntersect1(scene, (RTCRayHit*)&rayhit);
-  }
+bool EmbreeRayTracer::point_in_volume(SurfaceTreeID tree,
+                                const Position& point,
+                                const Direction* direction,
+                                const std::vector<MeshID>* exclude_primitives) const
+{
+  Direction dir = direction ? *direction : Direction {1. / std::sqrt(2.0), 1 / std::sqrt(2.0), 0.0};
+  auto rayhit = fire_surface_ray(tree, point, dir, INFTY, HitOrientation::ANY, exclude_primitives, nullptr);
 
   // if the ray hit nothing, the point is outside of the volume
   if (rayhit.hit.geomID == RTC_INVALID_GEOMETRY_ID) return false;
@@ -286,6 +542,19 @@ bool EmbreeRayTracer::point_in_volume(SurfaceTreeID tree,
   return rayhit.ray.ddir.dot(rayhit.hit.dNg) > 0.0;
 }
 
+bool EmbreeRayTracer::point_in_volume_with_history(SurfaceTreeID tree,
+                                                   const Position& point,
+                                                   const Direction* direction,
+                                                   const RayHistory* history) const
+{
+  Direction dir = direction ? *direction : Direction {1. / std::sqrt(2.0), 1 / std::sqrt(2.0), 0.0};
+  auto rayhit = fire_surface_ray(tree, point, dir, INFTY, HitOrientation::ANY, nullptr, history);
+
+  if (rayhit.hit.geomID == RTC_INVALID_GEOMETRY_ID) return false;
+
+  return rayhit.ray.ddir.dot(rayhit.hit.dNg) > 0.0;
+}
+
 std::pair<double, MeshID>
 EmbreeRayTracer::ray_fire(SurfaceTreeID tree,
                     const Position& origin,
@@ -294,35 +563,79 @@ EmbreeRayTracer::ray_fire(SurfaceTreeID tree,
                     HitOrientation orientation,
                     std::vector<MeshID>* const exclude_primitves)
 {
-  RTCScene scene = surface_volume_tree_to_scene_map_.at(tree);
-  RTCDualRayHit rayhit;
-  // set ray data
-  rayhit.ray.set_org(origin);
-  rayhit.ray.set_dir(direction);
-  rayhit.ray.set_tfar(dist_limit);
-  rayhit.ray.set_tnear(0.0);
-  rayhit.ray.rf_type = RayFireType::VOLUME;
-  rayhit.ray.orientation = orientation;
-  rayhit.ray.mask = -1; // no mask
-  rayhit.ray.volume_tree = tree;
+  auto rayhit = fire_surface_ray(tree, origin, direction, dist_limit, orientation, exclude_primitves, nullptr);
 
-  if (exclude_primitves != nullptr) rayhit.ray.exclude_primitives = exclude_primitves;
+  if (rayhit.hit.geomID == RTC_INVALID_GEOMETRY_ID)
+    return {INFTY, ID_NONE};
 
-  // fire the ray
-  {
-    rtcIntersect1(scene, (RTCRayHit*)&rayhit);
-    // TODO: I don't quite understand this...
-    rayhit.hit.Ng_x *= -1.0;
-    rayhit.hit.Ng_y *= -1.0;
-    rayhit.hit.Ng_z *= -1.0;
-  }
+  if (exclude_primitves) exclude_primitves->push_back(rayhit.hit.primitive_ref->primitive_id);
+  return {rayhit.ray.dtfar, rayhit.hit.surface};
+}
+
+std::pair<double, MeshID>
+EmbreeRayTracer::ray_fire_with_history(SurfaceTreeID tree,
+                                       const Position& origin,
+                                       const Direction& direction,
+                                       const double dist_limit,
+                                       HitOrientation orientation,
+                                       RayHistory* history)
+{
+  auto rayhit = fire_surface_ray(tree, origin, direction, dist_limit, orientation, nullptr, history);
 
   if (rayhit.hit.geomID == RTC_INVALID_GEOMETRY_ID)
     return {INFTY, ID_NONE};
-  else
 
-    if (exclude_primitves) exclude_primitves->push_back(rayhit.hit.primitive_ref->primitive_id);
-    return {rayhit.ray.dtfar, rayhit.hit.surface};
+  if (history) history->push_back(rayhit.hit.primitive_ref->primitive_id);
+  return {rayhit.ray.dtfar, rayhit.hit.surface};
+}
+
+void EmbreeRayTracer::point_in_volume_batch(SurfaceTreeID tree,
+                                            size_t n_points,
+                                            const Position* points,
+                                            const Direction* directions,
+                                            PointInVolume* results) const
+{
+  // see ray_fire_batch regarding Embree's packet interfaces
+  #pragma omp parallel for schedule(runtime)
+  for (size_t i = 0; i < n_points; ++i) {
+    const Direction* direction = directions ? directions + i : nullptr;
+    results[i] = point_in_volume(tree, points[i], direction) ? INSIDE : OUTSIDE;
+  }
+}
+
+void EmbreeRayTracer::find_volume_by_ray_batch(TreeID tree,
+                                               const MeshManager& mesh_manager,
+                                               size_t n_points,
+                                               const Position* points,
+                                               const Direction* directions,
+                                               MeshID* volumes,
+                                               bool* resolved)
+{
+  const Direction default_direction {1. / std::sqrt(2.0), 1. / std::sqrt(2.0), 0.0};
+  #pragma omp parallel for schedule(runtime)
+  for (size_t i = 0; i < n_points; ++i) {
+    const Direction& direction = directions ? directions[i] : default_direction;
+    resolved[i] = find_volume_by_ray(tree, mesh_manager, points[i], direction, volumes[i]);
+  }
+}
+
+void EmbreeRayTracer::ray_fire_batch(size_t n_rays,
+                                     const TreeID* trees,
+                                     const Position* origins,
+                                     const Direction* directions,
+                                     const double* dist_limits,
+                                     double* distances,
+                                     MeshID* surfaces,
+                                     HitOrientation orientation)
+{
+  // The double precision ray/hit structures used by XDG's Embree callbacks
+  // are not compatible with Embree's SoA packet/stream layouts, so rays are
+  // traced individually with the batch split across threads
+  #pragma omp parallel for schedule(runtime)
+  for (size_t i = 0; i < n_rays; ++i) {
+    double dist_limit = dist_limits ? dist_limits[i] : INFTY;
+    std::tie(distances[i], surfaces[i]) = ray_fire(trees[i], origins[i], directions[i], dist_limit, orientation);
+  }
 }
 
 std::pair<double, MeshID> EmbreeRayTracer::closest(SurfaceTreeID tree,
@@ -360,6 +673,17 @@ bool EmbreeRayTracer::occluded(SurfaceTreeID tree,
   ray.flags = 0;
   ray.mask = -1; // no mask
 
+  if (surface_mode_ == EmbreeSurfaceMode::TRIANGLE) {
+    // Native triangle geometries only check candidates in double precision
+    // in the intersection filter, so occlusion is resolved with an
+    // intersection query rather than Embree's single precision occlusion test
+    RTCDualRayHit rayhit;
+    rayhit.ray = ray;
+    intersect(scene, rayhit);
+    distance = rayhit.hit.geomID == RTC_INVALID_GEOMETRY_ID ? INFTY : -INFTY;
+    return distance != INFTY;
+  }
+
   // fire the ray
   {
     rtcOccluded1(scene, (RTCRay*)&ray);
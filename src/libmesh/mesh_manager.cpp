@@ -32,6 +32,9 @@ void LibMeshManager::init() {
     fatal_error("Mesh must be 3-dimensional");
   }
 
+  // the topology is read from the mesh again
+  invalidate_topology();
+
   num_elements_ = mesh()->n_active_elem();
 
   auto libmesh_bounding_box = libMesh::MeshTools::create_bounding_box(*mesh());
@@ -74,12 +77,17 @@ void LibMeshManager::init() {
   // create an implicit complement
   create_implicit_complement();
 
+  // freeze the topology now that all surfaces and volumes exist
+  build_topology();
+
   // libMesh initialization
   if (managed_mesh_) {
     managed_mesh_->prepare_for_use();
   }
 
   map_id_spaces();
+
+  build_tet_mesh();
 }
 
 MeshID LibMeshManager::adjacent_element(MeshID element, int face) const {
@@ -152,6 +160,7 @@ MeshID LibMeshManager::create_volume() {
 }
 
 void LibMeshManager::add_surface_to_volume(MeshID volume, MeshID surface, Sense sense, bool overwrite) {
+    invalidate_topology();
     auto senses = surface_senses(surface);
     if (sense == Sense::FORWARD) {
       if (!overwrite && senses.first != ID_NONE) {
@@ -199,6 +208,8 @@ void LibMeshManager::parse_metadata() {
       volume_metadata_[{volume, PropertyType::MATERIAL}] = {PropertyType::MATERIAL, subdomain_name};
     }
   }
+
+  build_property_tables();
 }
 
 void LibMeshManager::map_id_spaces() {
@@ -553,6 +564,8 @@ LibMeshManager::face_vertices(MeshID element) const {
 
 std::vector<MeshID>
 LibMeshManager::get_volume_surfaces(MeshID volume) const {
+  if (topology_.has_volume(volume)) return topology_.volume_surfaces(volume);
+
   // walk the surface senses and return the surfaces that have this volume
   // as an entry
   std::vector<MeshID> surfaces;
@@ -566,6 +579,8 @@ LibMeshManager::get_volume_surfaces(MeshID volume) const {
 
 std::pair<MeshID, MeshID>
 LibMeshManager::surface_senses(MeshID surface) const {
+  auto parents = topology_.surface_senses(surface);
+  if (parents.first != ID_NONE || parents.second != ID_NONE) return parents;
   return surface_senses_.at(surface);
 }
 
@@ -1,5 +1,6 @@
 #include "xdg/mesh_manager_interface.h"
 
+#include <map>
 #include <set>
 
 #include "xdg/config.h"
@@ -7,6 +8,7 @@
 #include "xdg/geometry/plucker.h"
 #include "xdg/geometry/face_common.h"
 #include "xdg/element_face_accessor.h"
+#include "xdg/tet_mesh.h"
 
 namespace xdg {
 
@@ -19,6 +21,9 @@ MeshManager::MeshManager() {
 MeshID
 MeshManager::create_implicit_complement()
 {
+  // a snapshot of the topology is rebuilt once the implicit complement is in place
+  bool rebuild_topology = has_topology();
+
   // create a new volume
   MeshID ipc_volume = this->create_volume();
 
@@ -38,6 +43,8 @@ MeshManager::create_implicit_complement()
 
   // TODO: allow for alternate material assignment in IPC
   volume_metadata_[{ipc_volume, PropertyType::MATERIAL}] = VOID_MATERIAL;
+  if (has_property_tables()) build_property_tables();
+  if (rebuild_topology) build_topology();
 
   implicit_complement_ = ipc_volume;
 
@@ -59,6 +66,7 @@ MeshID MeshManager::next_surface_id() const
 bool
 MeshManager::volume_has_property(MeshID volume, PropertyType type) const
 {
+  if (volume_property_id(volume, type) != PROPERTY_NONE) return true;
   return volume_metadata_.count({volume, type}) > 0;
 }
 
@@ -86,52 +94,46 @@ MeshManager::get_volume_faces(MeshID volume) const
 bool
 MeshManager::surface_has_property(MeshID surface, PropertyType type) const
 {
+  if (surface_property_id(surface, type) != PROPERTY_NONE) return true;
   return surface_metadata_.count({surface, type}) > 0;
 }
 
-Property
+const Property&
 MeshManager::get_volume_property(MeshID volume, PropertyType type) const
 {
+  PropertyID id = volume_property_id(volume, type);
+  if (id != PROPERTY_NONE) return volume_properties_.value(type, id);
   return volume_metadata_.at({volume, type});
 }
 
-Property
+const Property&
 MeshManager::get_surface_property(MeshID surface, PropertyType type) const
 {
+  PropertyID id = surface_property_id(surface, type);
+  if (id != PROPERTY_NONE) return surface_properties_.value(type, id);
   if (surface_metadata_.count({surface, type}) == 0)
-    return {PropertyType::BOUNDARY_CONDITION, "transmission"};
+    return TRANSMISSION_BOUNDARY;
   return surface_metadata_.at({surface, type});
 }
 
+void
+MeshManager::build_property_tables()
+{
+  volume_properties_ = PropertyTable(volumes(), volume_metadata_);
+  surface_properties_ = PropertyTable(surfaces(), surface_metadata_);
+}
+
 std::vector<std::pair<MeshID, double>>
 MeshManager::walk_elements(MeshID starting_element,
                            const Position& start,
                            const Direction& u,
                            double distance) const
 {
-  // a copy of the start position that will be updated as elements are traversed
-  Position r = start;
   std::vector<std::pair<MeshID, double>> result;
-
-  MeshID elem = starting_element;
-  while (distance > 0) {
-    // find the exit point from the current element and determine the next element
-    // if one exists
-    auto exit = next_element(elem, r, u);
-    // ensure we are not traveling beyond the end of the ray
-    exit.second = std::min(exit.second, distance);
-    distance -= exit.second;
-    // only add to the result if the distance is greater than 0
-    result.push_back({elem, exit.second});
-    r += exit.second * u;
-    elem = exit.first;
-
-    // if there is no next element, we're exiting the mesh
-    if (elem == ID_NONE) {
-      break;
-    }
-  }
-
+  walk_elements(starting_element, start, u, distance, [&](MeshID element, double length) {
+    result.push_back({element, length});
+    return true;
+  });
   return result;
 }
 
@@ -146,11 +148,23 @@ MeshManager::walk_elements(MeshID starting_element,
   return walk_elements(starting_element, start, u, distance);
 }
 
+void
+MeshManager::build_tet_mesh()
+{
+  tet_mesh_ = TetMesh::from_mesh(*this);
+}
+
 std::pair<MeshID, double>
 MeshManager::next_element(MeshID current_element,
                            const Position& r,
                            const Position& u) const
 {
+  if (tet_mesh_ && tet_mesh_->contains(current_element)) {
+    auto exit = tet_mesh_->next_element(tet_mesh_->element_index(current_element), r, u);
+    MeshID next_element = exit.first == INDEX_NONE ? ID_NONE : tet_mesh_->element_id(exit.first);
+    return {next_element, exit.second};
+  }
+
   std::array<double, 4> dists = {INFTY, INFTY, INFTY, INFTY};
   std::array<bool, 4> hit_types;
 
@@ -161,9 +175,6 @@ MeshManager::next_element(MeshID current_element,
     // triangle connectivity
     auto coords = element_face_accessor->face_vertices(i);
 
-    // get the normal of the triangle face
-    const Position normal = triangle_normal(coords);
-
     // exiting hit only, assumes triangle normals point outward
     // with respect to the element
     int orientation = 1;
@@ -215,17 +226,116 @@ MeshID MeshManager::next_volume(MeshID current_volume, MeshID surface) const
 
 Direction MeshManager::face_normal(MeshID element) const
 {
-  auto vertices = this->face_vertices(element);
-  return (vertices[1] - vertices[0]).cross(vertices[2] - vertices[0]).normalize();
+  return face_plane(element).normal;
+}
+
+FacePlane MeshManager::face_plane(MeshID element) const
+{
+  if (!face_planes_.empty()) {
+    MeshIndex idx = face_id_map_.id_to_index(element);
+    if (idx != INDEX_NONE) return face_planes_[face_plane_indices_[idx]];
+  }
+  return triangle_plane(this->face_vertices(element));
+}
+
+const FacePlane*
+MeshManager::surface_face_planes(MeshID surface) const
+{
+  auto it = surface_plane_offsets_.find(surface);
+  if (it == surface_plane_offsets_.end()) return nullptr;
+  return face_planes_.data() + it->second;
+}
+
+void
+MeshManager::build_face_planes()
+{
+  // surface trees and the tetrahedral mesh point into the cache
+  if (has_face_planes()) return;
+
+  // planes of the faces of each surface are stored contiguously so that a
+  // surface tree can read them in primitive order
+  std::vector<std::pair<MeshID, MeshIndex>> face_indices;
+  for (auto surface : surfaces()) {
+    surface_plane_offsets_[surface] = face_planes_.size();
+    for (auto face : this->get_surface_faces(surface)) {
+      face_indices.push_back({face, static_cast<MeshIndex>(face_planes_.size())});
+      face_planes_.push_back(triangle_plane(this->face_vertices(face)));
+    }
+  }
+
+  std::sort(face_indices.begin(), face_indices.end());
+  face_indices.erase(std::unique(face_indices.begin(), face_indices.end(),
+                                 [](const auto& a, const auto& b) { return a.first == b.first; }),
+                     face_indices.end());
+  std::vector<MeshID> faces(face_indices.size());
+  face_plane_indices_.resize(face_indices.size());
+  for (size_t i = 0; i < face_indices.size(); ++i) {
+    faces[i] = face_indices[i].first;
+    face_plane_indices_[i] = face_indices[i].second;
+  }
+  face_id_map_ = IDBlockMapping<MeshID>(faces);
+
+  if (tet_mesh_) {
+    // element faces lying on a surface reuse the plane of the surface face
+    std::map<std::array<MeshID, 3>, MeshIndex> surface_faces;
+    for (const auto& [face, idx] : face_indices) {
+      auto connectivity = this->face_connectivity(face);
+      if (connectivity.size() != 3) continue;
+      std::array<MeshID, 3> key {connectivity[0], connectivity[1], connectivity[2]};
+      std::sort(key.begin(), key.end());
+      surface_faces[key] = idx;
+    }
+    tet_mesh_->build_face_planes(face_planes_, surface_faces);
+  }
+}
+
+void
+MeshManager::build_volume_tables()
+{
+  element_volumes_.clear();
+  for (auto volume : volumes()) {
+    for (auto element : this->get_volume_elements(volume)) {
+      MeshIndex idx = element_index(element);
+      if (idx == INDEX_NONE) continue;
+      if (idx >= static_cast<MeshIndex>(element_volumes_.size())) element_volumes_.resize(idx + 1, ID_NONE);
+      element_volumes_[idx] = volume;
+    }
+  }
 }
 
 BoundingBox
 MeshManager::element_bounding_box(MeshID element) const
 {
+  if (tet_mesh_) {
+    MeshIndex idx = tet_mesh_->element_index(element);
+    if (idx != INDEX_NONE) return BoundingBox::from_points(tet_mesh_->element_vertices(idx));
+  }
   auto vertices = this->element_vertices(element);
   return BoundingBox::from_points(vertices);
 }
 
+std::vector<BoundingBox>
+MeshManager::element_bounding_boxes(const MeshID* elements, size_t n_elements) const
+{
+  std::vector<BoundingBox> bounds(n_elements);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n_elements; ++i) {
+    bounds[i] = element_bounding_box(elements[i]);
+  }
+  return bounds;
+}
+
+std::array<Vertex, 4>
+MeshManager::tet_vertices(MeshID element) const
+{
+  if (tet_mesh_) {
+    MeshIndex idx = tet_mesh_->element_index(element);
+    if (idx != INDEX_NONE) return tet_mesh_->element_vertices(idx);
+  }
+  auto vertices = this->element_vertices(element);
+  return {vertices[0], vertices[1], vertices[2], vertices[3]};
+}
+
 BoundingBox
 MeshManager::face_bounding_box(MeshID element) const
 {
@@ -269,9 +379,28 @@ MeshManager::surface_bounding_box(MeshID surface) const
 std::pair<MeshID, MeshID>
 MeshManager::get_parent_volumes(MeshID surface) const
 {
+  auto parents = topology_.surface_senses(surface);
+  if (parents.first != ID_NONE || parents.second != ID_NONE) return parents;
   return this->surface_senses(surface);
 }
 
+void
+MeshManager::build_topology()
+{
+  // read the topology from the mesh library rather than a previous snapshot
+  invalidate_topology();
+
+  std::vector<std::vector<MeshID>> volume_surfaces;
+  volume_surfaces.reserve(volumes().size());
+  for (auto volume : volumes()) volume_surfaces.push_back(this->get_volume_surfaces(volume));
+
+  std::vector<std::pair<MeshID, MeshID>> senses;
+  senses.reserve(surfaces().size());
+  for (auto surface : surfaces()) senses.push_back(this->surface_senses(surface));
+
+  topology_ = TopologyTable(volumes(), volume_surfaces, surfaces(), senses);
+}
+
 MeshManager::LocalMeshData
 MeshManager::surface_local_mesh_data(MeshID surface) const
 {
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
 
 // MOAB
 #include "moab/Range.hpp"
@@ -7,6 +11,40 @@
 
 namespace xdg {
 
+namespace {
+
+// An element face or triangle keyed by its sorted vertices. Vertices are
+// stored as 32-bit offsets into the vertex block index rather than handles
+// to halve the size of the keys, which dominate the memory used to build
+// the adjacencies of large meshes.
+struct FaceKey {
+  std::array<uint32_t, 3> vertices;
+  uint32_t slot; //!< Element face (element index * faces per element + face number) or triangle
+};
+static_assert(sizeof(FaceKey) == 16, "FaceKey should be 16 bytes");
+
+FaceKey make_face_key(uint32_t v0, uint32_t v1, uint32_t v2, size_t slot)
+{
+  FaceKey key {{v0, v1, v2}, static_cast<uint32_t>(slot)};
+  std::sort(key.vertices.begin(), key.vertices.end());
+  return key;
+}
+
+size_t face_hash(const FaceKey& key)
+{
+  size_t hash = 0;
+  for (auto v : key.vertices) {
+    hash ^= std::hash<uint32_t>()(v) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+// Upper bound on the number of face keys held at once (512 MB). Larger
+// meshes are matched in several passes over the faces.
+constexpr size_t MAX_FACE_KEYS_PER_PASS {size_t(1) << 25};
+
+} // namespace
+
 MBDirectAccess::MBDirectAccess(Interface* mbi)
 : mbi(mbi)
 {
@@ -17,11 +55,11 @@ MBDirectAccess::MBDirectAccess(Interface* mbi)
 
 void
 MBDirectAccess::setup() {
+  clear();
   face_data_.setup(mbi);
   element_data_.setup(mbi);
   vertex_data_.setup(mbi);
-  element_adjacency_data_.setup(mbi);
-  boundary_face_adjacency_data_.setup(mbi, face_data_);
+  element_adjacency_data_.setup(element_data_, face_data_, vertex_data_);
 }
 
 void
@@ -31,7 +69,131 @@ MBDirectAccess::clear()
   element_data_.clear();
   vertex_data_.clear();
   element_adjacency_data_.clear();
-  boundary_face_adjacency_data_.clear();
+}
+
+void
+MBDirectAccess::AdjacencyData::setup(const ConnectivityData& element_data,
+                                     const ConnectivityData& face_data,
+                                     const VertexData& vertex_data)
+{
+  const auto& ord = ordering.at(entity_type);
+  faces_per_element = ord.size();
+  num_entities = std::max(element_data.num_entities, 0);
+  const size_t n_element_faces = num_entities * faces_per_element;
+  const size_t n_triangles = std::max(face_data.num_entities, 0);
+  const size_t n_keys = n_element_faces + n_triangles;
+
+  if (n_keys > std::numeric_limits<uint32_t>::max() ||
+      vertex_data.block_index.blocks.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Too many faces or vertices to build element adjacencies");
+  }
+
+  neighbors.assign(n_element_faces, xdg::ID_NONE);
+  boundary_face_elements.assign(n_triangles, xdg::ID_NONE);
+
+  // vertices are keyed by their offset in the vertex block index
+  const EntityHandle min_vertex = vertex_data.block_index.min_handle;
+  auto v = [min_vertex](EntityHandle vertex) { return static_cast<uint32_t>(vertex - min_vertex); };
+
+  // visit the faces of every element and every triangle keyed by their sorted vertices
+  auto for_each_face = [&](auto&& visit) {
+    for (size_t block = 0; block < element_data.first_elements.size(); block++) {
+      const EntityHandle* conn = element_data.vconn[block];
+      const size_t first_index = element_data.first_indices[block];
+      const int64_t n_block = element_data.first_elements[block].second;
+      #pragma omp parallel for
+      for (int64_t i = 0; i < n_block; i++) {
+        const EntityHandle* element_conn = conn + element_data.element_stride * i;
+        size_t slot = faces_per_element * (first_index + i);
+        for (const auto& o : ord) {
+          visit(make_face_key(v(element_conn[o[0]]), v(element_conn[o[1]]), v(element_conn[o[2]]), slot++));
+        }
+      }
+    }
+    for (size_t block = 0; block < face_data.first_elements.size(); block++) {
+      const EntityHandle* conn = face_data.vconn[block];
+      const size_t first_index = face_data.first_indices[block];
+      const int64_t n_block = face_data.first_elements[block].second;
+      #pragma omp parallel for
+      for (int64_t i = 0; i < n_block; i++) {
+        const EntityHandle* tri_conn = conn + face_data.element_stride * i;
+        visit(make_face_key(v(tri_conn[0]), v(tri_conn[1]), v(tri_conn[2]), n_element_faces + first_index + i));
+      }
+    }
+  };
+
+  // distribute the keys into buckets by hash so that matching faces share a
+  // bucket and buckets can be matched independently
+  const size_t n_buckets = std::max<size_t>(1, n_keys / 64);
+  std::vector<size_t> bucket_offsets(n_buckets + 1, 0);
+  for_each_face([&](const FaceKey& key) {
+    size_t bucket = face_hash(key) % n_buckets;
+    #pragma omp atomic
+    bucket_offsets[bucket + 1]++;
+  });
+  for (size_t b = 0; b < n_buckets; b++) bucket_offsets[b + 1] += bucket_offsets[b];
+
+  // gather and match the keys of a range of buckets at a time to bound the
+  // memory used by the keys
+  std::vector<FaceKey> keys;
+  std::vector<size_t> bucket_fill(bucket_offsets.begin(), bucket_offsets.end() - 1);
+  bool non_manifold = false;
+  for (size_t pass_begin = 0; pass_begin < n_buckets;) {
+    size_t pass_end = pass_begin + 1;
+    while (pass_end < n_buckets &&
+           bucket_offsets[pass_end + 1] - bucket_offsets[pass_begin] <= MAX_FACE_KEYS_PER_PASS) pass_end++;
+    const size_t key_offset = bucket_offsets[pass_begin];
+    keys.resize(bucket_offsets[pass_end] - key_offset);
+
+    for_each_face([&](const FaceKey& key) {
+      size_t bucket = face_hash(key) % n_buckets;
+      if (bucket < pass_begin || bucket >= pass_end) return;
+      size_t position;
+      #pragma omp atomic capture
+      position = bucket_fill[bucket]++;
+      keys[position - key_offset] = key;
+    });
+
+    // faces shared by two elements connect them as neighbors, triangles
+    // matching the face of a single element are on the boundary
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int64_t b = pass_begin; b < static_cast<int64_t>(pass_end); b++) {
+      auto begin = keys.begin() + (bucket_offsets[b] - key_offset);
+      auto end = keys.begin() + (bucket_offsets[b + 1] - key_offset);
+      std::sort(begin, end, [](const FaceKey& a, const FaceKey& b) {
+        return a.vertices < b.vertices || (a.vertices == b.vertices && a.slot < b.slot);
+      });
+
+      for (auto run = begin; run != end;) {
+        auto run_end = run;
+        while (run_end != end && run_end->vertices == run->vertices) run_end++;
+
+        // element faces sort ahead of triangles in each run
+        auto triangles = run;
+        while (triangles != run_end && triangles->slot < n_element_faces) triangles++;
+        size_t n_adjacent = triangles - run;
+
+        if (n_adjacent > 2) {
+          #pragma omp atomic write
+          non_manifold = true;
+        } else if (n_adjacent == 2) {
+          neighbors[run->slot] = element_data.handle((run + 1)->slot / faces_per_element);
+          neighbors[(run + 1)->slot] = element_data.handle(run->slot / faces_per_element);
+        } else if (n_adjacent == 1) {
+          EntityHandle element = element_data.handle(run->slot / faces_per_element);
+          for (auto tri = triangles; tri != run_end; tri++) {
+            boundary_face_elements[tri->slot - n_element_faces] = element;
+          }
+        }
+        run = run_end;
+      }
+    }
+    pass_begin = pass_end;
+  }
+
+  if (non_manifold) {
+    throw std::runtime_error("Found more than two elements adjacent to a face");
+  }
 }
 
 void
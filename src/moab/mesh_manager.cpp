@@ -35,6 +35,9 @@ MOABMeshManager::MOABMeshManager(moab::Interface* mbi) : moab_raw_ptr_(mbi)
 };
 
 void MOABMeshManager::init() {
+  // the topology is read from the mesh again
+  invalidate_topology();
+
   // initialize the direct access manager
   this->mb_direct()->setup();
 
@@ -104,6 +107,10 @@ void MOABMeshManager::init() {
   }
 
   MeshID ipc = create_implicit_complement();
+
+  build_topology();
+
+  build_tet_mesh();
 }
 
 void MOABMeshManager::setup_tags() {
@@ -219,6 +226,7 @@ void MOABMeshManager::add_surface_to_volume(MeshID volume, MeshID surface, Sense
   moab::EntityHandle vol_handle = volume_id_map_.at(volume);
   moab::EntityHandle surf_handle = surface_id_map_.at(surface);
   this->moab_interface()->add_parent_child(vol_handle, surf_handle);
+  invalidate_topology();
 
   // insert new volume into sense data
   auto sense_data = this->surface_senses(surface);
@@ -339,16 +347,14 @@ MOABMeshManager::get_surface_faces(MeshID surface) const
 
 std::vector<Vertex> MOABMeshManager::element_vertices(MeshID element) const
 {
-  moab::EntityHandle element_handle;
-  this->moab_interface()->handle_from_id(moab::MBTET, element, element_handle);
+  moab::EntityHandle element_handle = this->mb_direct()->element_handle(element);
   auto out = this->mb_direct()->get_element_coords(element_handle);
   return std::vector<Vertex>(out.begin(), out.end());
 }
 
 std::array<Vertex, 3> MOABMeshManager::face_vertices(MeshID element) const
 {
-  moab::EntityHandle element_handle;
-  this->moab_interface()->handle_from_id(moab::MBTRI, element, element_handle);
+  moab::EntityHandle element_handle = this->mb_direct()->face_handle(element);
   auto out = this->mb_direct()->get_mb_coords(element_handle);
   return out;
 }
@@ -356,6 +362,9 @@ std::array<Vertex, 3> MOABMeshManager::face_vertices(MeshID element) const
 std::pair<MeshID, MeshID>
 MOABMeshManager::surface_senses(MeshID surface) const
 {
+  auto parents = topology_.surface_senses(surface);
+  if (parents.first != ID_NONE || parents.second != ID_NONE) return parents;
+
   moab::EntityHandle surf_handle = surface_id_map_.at(surface);
   std::vector<moab::EntityHandle> sense_data = this->tag_data<moab::EntityHandle>(surf_to_volume_sense_tag_, surf_handle, 2);
 
@@ -399,6 +408,8 @@ MOABMeshManager::_ents_of_dim(int dim) const {
 std::vector<MeshID>
 MOABMeshManager::get_volume_surfaces(MeshID volume) const
 {
+  if (topology_.has_volume(volume)) return topology_.volume_surfaces(volume);
+
   moab::EntityHandle vol_handle = this->volume_id_map_.at(volume);
 
   std::vector<moab::EntityHandle> surfaces;
@@ -429,11 +440,10 @@ MOABMeshManager::get_surface_element_type(MeshID surface) const
 MeshID
 MOABMeshManager::adjacent_element(MeshID element, int face) const
 {
-  moab::EntityHandle element_handle;
-  this->moab_interface()->handle_from_id(moab::MBTET, element, element_handle);
+  moab::EntityHandle element_handle = this->mb_direct()->element_handle(element);
   moab::EntityHandle next_element = this->mb_direct()->get_adjacent_element(element_handle, face);
   if (next_element == ID_NONE) return ID_NONE;
-  return this->moab_interface()->id_from_handle(next_element);
+  return this->mb_direct()->element_id(next_element);
 }
 
 xdg::Vertex
@@ -449,38 +459,34 @@ MOABMeshManager::vertex_coordinates(MeshID vertex_id) const
 std::vector<MeshID>
 MOABMeshManager::element_connectivity(MeshID element) const
 {
-  moab::EntityHandle element_handle;
-  this->moab_interface()->handle_from_id(moab::MBTET, element, element_handle);
+  moab::EntityHandle element_handle = this->mb_direct()->element_handle(element);
   return this->mb_direct()->get_element_connectivity(element_handle);
 }
 
 std::vector<MeshID>
 MOABMeshManager::face_connectivity(MeshID face) const
 {
-  moab::EntityHandle face_handle;
-  this->moab_interface()->handle_from_id(moab::MBTRI, face, face_handle);
+  moab::EntityHandle face_handle = this->mb_direct()->face_handle(face);
   return this->mb_direct()->get_face_connectivity(face_handle);
 }
 
 MeshID
 MOABMeshManager::get_boundary_face_element(MeshID face) const
 {
-  moab::EntityHandle face_handle;
-  this->moab_interface()->handle_from_id(moab::MBTRI, face, face_handle);
+  moab::EntityHandle face_handle = this->mb_direct()->face_handle(face);
 
   moab::EntityHandle element_handle = this->mb_direct()->get_boundary_face_element(face_handle);
   if (element_handle == ID_NONE) {
     return ID_NONE;
   }
 
-  return this->moab_interface()->id_from_handle(element_handle);
+  return this->mb_direct()->element_id(element_handle);
 }
 
 double
 MOABMeshManager::element_volume(MeshID element) const
 {
-  moab::EntityHandle element_handle;
-  this->moab_interface()->handle_from_id(moab::MBTET, element, element_handle);
+  moab::EntityHandle element_handle = this->mb_direct()->element_handle(element);
   std::array<xdg::Vertex, 4> verts = this->mb_direct()->get_element_coords(element_handle);
   return tetrahedron_volume(verts);
 }
@@ -588,6 +594,8 @@ MOABMeshManager::parse_metadata()
   }
 
   graveyard_check();
+
+  build_property_tables();
 }
 
 void
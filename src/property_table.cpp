@@ -0,0 +1,38 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "xdg/property_table.h"
+
+namespace xdg {
+
+PropertyTable::PropertyTable(const std::vector<MeshID>& entities,
+                             const std::map<std::pair<MeshID, PropertyType>, Property>& metadata)
+{
+  std::vector<MeshID> sorted_entities = entities;
+  std::sort(sorted_entities.begin(), sorted_entities.end());
+  sorted_entities.erase(std::unique(sorted_entities.begin(), sorted_entities.end()), sorted_entities.end());
+  entity_map_ = IDBlockMapping<MeshID>(sorted_entities);
+  size_ = sorted_entities.size();
+
+  for (auto& ids : ids_) ids.assign(size_, PROPERTY_NONE);
+
+  // values are interned in the order they are first assigned
+  std::array<std::unordered_map<std::string, PropertyID>, N_PROPERTY_TYPES> interned;
+  for (const auto& [key, property] : metadata) {
+    MeshIndex idx = entity_map_.id_to_index(key.first);
+    if (idx == INDEX_NONE) continue;
+    size_t t = type_index(key.second);
+    auto [it, inserted] = interned[t].emplace(property.value, values_[t].size());
+    if (inserted) values_[t].push_back({key.second, property.value});
+    ids_[t][idx] = it->second;
+  }
+}
+
+PropertyID PropertyTable::value_id(PropertyType type, const std::string& value) const
+{
+  const auto& values = values_[type_index(type)];
+  auto it = std::find_if(values.begin(), values.end(), [&](const Property& p) { return p.value == value; });
+  return it == values.end() ? PROPERTY_NONE : it - values.begin();
+}
+
+} // namespace xdg
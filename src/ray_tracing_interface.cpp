@@ -1,4 +1,7 @@
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <tuple>
 #include "xdg/ray_tracing_interface.h"
 
 // Any methods which are identical for all RT backends should be defined here
@@ -17,6 +20,170 @@ ElementTreeID RayTracer::next_element_tree_id()
   return ++next_element_tree_id_;
 }
 
+std::vector<std::pair<TreeID, TreeID>>
+RayTracer::register_volumes(const std::shared_ptr<MeshManager>& mesh_manager,
+                            const std::vector<MeshID>& volumes)
+{
+  std::vector<std::pair<TreeID, TreeID>> trees;
+  trees.reserve(volumes.size());
+  for (auto volume : volumes) {
+    trees.push_back(register_volume(mesh_manager, volume));
+  }
+  return trees;
+}
+
+void RayTracer::create_global_trees()
+{
+  create_global_element_tree();
+  create_global_surface_tree();
+}
+
+bool RayTracer::find_volume_by_ray(TreeID tree,
+                                   const MeshManager& mesh_manager,
+                                   const Position& point,
+                                   const Direction& direction,
+                                   MeshID& volume)
+{
+  // hits at a smaller angle to the face than this are treated as tangential
+  // and the ray is fired again in another direction
+  constexpr double GRAZING_COSINE {1e-3};
+  const std::array<Direction, 4> directions {
+    direction,
+    Direction(0.6156614753256583, 0.6156614753256583, 0.4915290385296242),
+    Direction(-0.4915290385296242, 0.6156614753256583, -0.6156614753256583),
+    Direction(0.6156614753256583, -0.4915290385296242, -0.6156614753256583)
+  };
+
+  MeshID ipc = mesh_manager.implicit_complement();
+  bool missed {false};
+  for (auto dir : directions) {
+    dir.normalize();
+    RayHistory history;
+    MeshID surface = ray_fire_with_history(tree, point, dir, INFTY, HitOrientation::ANY, &history).second;
+
+    // a ray may slip between adjacent faces, so an escaping ray must be
+    // confirmed by a second one before the point is placed outside all volumes
+    if (surface == ID_NONE) {
+      if (missed) {
+        volume = ipc;
+        return true;
+      }
+      missed = true;
+      continue;
+    }
+
+    // normals point out of the forward volume of a surface, so a ray
+    // travelling along the normal started in the forward volume
+    double cosine = dir.dot(mesh_manager.face_normal(history.back()));
+    if (std::abs(cosine) < GRAZING_COSINE) continue;
+
+    auto senses = mesh_manager.surface_senses(surface);
+    volume = cosine > 0.0 ? senses.first : senses.second;
+    if (volume == ID_NONE) volume = ipc;
+    return true;
+  }
+  return false;
+}
+
+void RayTracer::find_volume_by_ray_batch(TreeID tree,
+                                         const MeshManager& mesh_manager,
+                                         size_t n_points,
+                                         const Position* points,
+                                         const Direction* directions,
+                                         MeshID* volumes,
+                                         bool* resolved)
+{
+  const Direction default_direction {1. / std::sqrt(2.0), 1. / std::sqrt(2.0), 0.0};
+  for (size_t i = 0; i < n_points; ++i) {
+    const Direction& direction = directions ? directions[i] : default_direction;
+    resolved[i] = find_volume_by_ray(tree, mesh_manager, points[i], direction, volumes[i]);
+  }
+}
+
+size_t RayTracer::find_element_batch(size_t n_points,
+                                     const Position* points,
+                                     MeshID* elements,
+                                     bool* missed) const
+{
+  return find_element_batch(global_element_tree_, n_points, points, elements, missed);
+}
+
+size_t RayTracer::find_element_batch(TreeID tree,
+                                     size_t n_points,
+                                     const Position* points,
+                                     MeshID* elements,
+                                     bool* missed) const
+{
+  size_t n_missed = 0;
+  for (size_t i = 0; i < n_points; ++i) {
+    elements[i] = find_element(tree, points[i]);
+    if (elements[i] == ID_NONE) n_missed++;
+    if (missed) missed[i] = elements[i] == ID_NONE;
+  }
+  return n_missed;
+}
+
+bool RayTracer::point_in_volume_with_history(TreeID tree,
+                                             const Position& point,
+                                             const Direction* direction,
+                                             const RayHistory* history) const
+{
+  if (!history) return point_in_volume(tree, point, direction);
+
+  std::vector<MeshID> exclude_primitives(history->size());
+  for (size_t i = 0; i < history->size(); ++i) exclude_primitives[i] = (*history)[i];
+  return point_in_volume(tree, point, direction, &exclude_primitives);
+}
+
+std::pair<double, MeshID> RayTracer::ray_fire_with_history(TreeID tree,
+                                                           const Position& origin,
+                                                           const Direction& direction,
+                                                           const double dist_limit,
+                                                           HitOrientation orientation,
+                                                           RayHistory* history)
+{
+  if (!history) return ray_fire(tree, origin, direction, dist_limit, orientation);
+
+  std::vector<MeshID> exclude_primitives(history->size());
+  for (size_t i = 0; i < history->size(); ++i) exclude_primitives[i] = (*history)[i];
+  auto hit = ray_fire(tree, origin, direction, dist_limit, orientation, &exclude_primitives);
+  // the hit primitive is appended to the exclusion list by the backend
+  if (hit.second != ID_NONE) history->push_back(exclude_primitives.back());
+  return hit;
+}
+
+void RayTracer::point_in_volume_batch(TreeID tree,
+                                      size_t n_points,
+                                      const Position* points,
+                                      const Direction* directions,
+                                      PointInVolume* results) const
+{
+  for (size_t i = 0; i < n_points; ++i) {
+    const Direction* direction = directions ? directions + i : nullptr;
+    results[i] = point_in_volume(tree, points[i], direction) ? INSIDE : OUTSIDE;
+  }
+}
+
+void RayTracer::ray_fire_batch(size_t n_rays,
+                               const TreeID* trees,
+                               const Position* origins,
+                               const Direction* directions,
+                               const double* dist_limits,
+                               double* distances,
+                               MeshID* surfaces,
+                               HitOrientation orientation)
+{
+  for (size_t i = 0; i < n_rays; ++i) {
+    double dist_limit = dist_limits ? dist_limits[i] : INFTY;
+    std::tie(distances[i], surfaces[i]) = ray_fire(trees[i], origins[i], directions[i], dist_limit, orientation);
+  }
+}
+
+uint64_t RayTracer::tree_build_key() const
+{
+  return TreeCache::hash_values(TreeCache::HASH_SEED, library(), numerical_precision_, FP_BOX_TOL);
+}
+
 const double RayTracer::bounding_box_bump(const std::shared_ptr<MeshManager> mesh_manager, MeshID volume_id)
 {
   auto volume_bounding_box = mesh_manager->volume_bounding_box(volume_id);
@@ -0,0 +1,233 @@
+#include <algorithm>
+
+#include "xdg/tet_mesh.h"
+#include "xdg/element_face_accessor.h"
+#include "xdg/error.h"
+#include "xdg/geometry/plucker.h"
+#include "xdg/mesh_manager_interface.h"
+
+namespace xdg {
+
+namespace {
+
+// local vertices of the six edges of a tetrahedron, ordered low to high
+constexpr int EDGE_VERTICES[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+
+// edge joining two local vertices (indexed low to high)
+constexpr int EDGE_INDEX[4][4] = {{-1, 0, 1, 2},
+                                  {-1, -1, 3, 4},
+                                  {-1, -1, -1, 5},
+                                  {-1, -1, -1, -1}};
+
+} // namespace
+
+std::shared_ptr<TetMesh> TetMesh::from_mesh(const MeshManager& mesh_manager)
+{
+  std::shared_ptr<TetMesh> mesh(new TetMesh());
+  std::unordered_map<MeshID, MeshIndex> vertex_indices;
+
+  auto same_position = [](const Vertex& a, const Vertex& b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+  };
+
+  for (auto volume : mesh_manager.volumes()) {
+    for (auto element : mesh_manager.get_volume_elements(volume)) {
+      if (mesh->element_indices_.count(element)) continue;
+
+      auto connectivity = mesh_manager.element_connectivity(element);
+      if (connectivity.size() != 4) return nullptr;
+
+      std::array<MeshIndex, 4> element_vertices;
+      for (int i = 0; i < 4; i++) {
+        auto [it, inserted] = vertex_indices.emplace(connectivity[i], mesh->vertices_.size());
+        if (inserted) {
+          mesh->vertices_.push_back(mesh_manager.vertex_coordinates(connectivity[i]));
+          mesh->vertex_ids_.push_back(connectivity[i]);
+        }
+        element_vertices[i] = it->second;
+      }
+
+      // the face ordering and orientation of each mesh library is captured
+      // by matching the vertices of each face to those of the element
+      auto element_face_accessor = ElementFaceAccessor::create(&mesh_manager, element);
+      std::array<int8_t, 12> faces;
+      for (int i = 0; i < 4; i++) {
+        auto coords = element_face_accessor->face_vertices(i);
+        for (int j = 0; j < 3; j++) {
+          auto match = std::find_if(element_vertices.begin(), element_vertices.end(),
+                                    [&](MeshIndex v) { return same_position(mesh->vertices_[v], coords[j]); });
+          if (match == element_vertices.end())
+            fatal_error("Face {} of element {} does not share its vertices with the element", i, element);
+          faces[3 * i + j] = match - element_vertices.begin();
+        }
+      }
+
+      mesh->element_indices_[element] = mesh->element_ids_.size();
+      mesh->element_ids_.push_back(element);
+      mesh->connectivity_.push_back(element_vertices);
+      mesh->faces_.push_back(faces);
+    }
+  }
+
+  if (mesh->element_ids_.empty()) return nullptr;
+
+  // neighbors are resolved once every element has an index
+  mesh->neighbors_.resize(mesh->element_ids_.size());
+  for (size_t i = 0; i < mesh->element_ids_.size(); i++) {
+    for (int j = 0; j < 4; j++) {
+      MeshID neighbor = mesh_manager.adjacent_element(mesh->element_ids_[i], j);
+      mesh->neighbors_[i][j] = neighbor == ID_NONE ? INDEX_NONE : mesh->element_index(neighbor);
+    }
+  }
+
+  // the face a ray enters a neighbor through is the neighbor's face shared with this element
+  mesh->neighbor_faces_.resize(mesh->element_ids_.size());
+  for (size_t i = 0; i < mesh->element_ids_.size(); i++) {
+    for (int j = 0; j < 4; j++) {
+      mesh->neighbor_faces_[i][j] = -1;
+      MeshIndex neighbor = mesh->neighbors_[i][j];
+      if (neighbor == INDEX_NONE) continue;
+      for (int k = 0; k < 4; k++) {
+        if (mesh->neighbors_[neighbor][k] == static_cast<MeshIndex>(i)) mesh->neighbor_faces_[i][j] = k;
+      }
+    }
+  }
+
+  return mesh;
+}
+
+void TetMesh::build_face_planes(std::vector<FacePlane>& planes,
+                                const std::map<std::array<MeshID, 3>, MeshIndex>& cached_faces)
+{
+  face_plane_indices_.resize(element_ids_.size());
+  for (size_t i = 0; i < element_ids_.size(); i++) {
+    for (int j = 0; j < 4; j++) {
+      // the neighbor with the lower index has already assigned the shared face
+      MeshIndex neighbor = neighbors_[i][j];
+      if (neighbor != INDEX_NONE && neighbor < static_cast<MeshIndex>(i) && neighbor_faces_[i][j] != -1) {
+        face_plane_indices_[i][j] = face_plane_indices_[neighbor][neighbor_faces_[i][j]];
+        continue;
+      }
+
+      std::array<MeshIndex, 3> face_vertices;
+      for (int k = 0; k < 3; k++) face_vertices[k] = connectivity_[i][faces_[i][3 * j + k]];
+
+      std::array<MeshID, 3> key;
+      for (int k = 0; k < 3; k++) key[k] = vertex_ids_[face_vertices[k]];
+      std::sort(key.begin(), key.end());
+      auto cached = cached_faces.find(key);
+      if (cached != cached_faces.end()) {
+        face_plane_indices_[i][j] = cached->second;
+        continue;
+      }
+
+      std::array<Vertex, 3> coords;
+      for (int k = 0; k < 3; k++) coords[k] = vertices_[face_vertices[k]];
+      face_plane_indices_[i][j] = planes.size();
+      planes.push_back(triangle_plane(coords));
+    }
+  }
+  face_planes_ = planes.data();
+}
+
+MeshIndex TetMesh::element_index(MeshID element) const
+{
+  auto it = element_indices_.find(element);
+  if (it == element_indices_.end()) return INDEX_NONE;
+  return it->second;
+}
+
+std::vector<std::pair<MeshID, double>>
+TetMesh::walk_elements(MeshID starting_element,
+                       const Position& start,
+                       const Direction& u,
+                       double distance) const
+{
+  std::vector<std::pair<MeshID, double>> result;
+  walk_elements(starting_element, start, u, distance, [&](MeshID element, double length) {
+    result.push_back({element, length});
+    return true;
+  });
+  return result;
+}
+
+std::pair<MeshIndex, double>
+TetMesh::next_element(MeshIndex element,
+                      const Position& r,
+                      const Direction& u) const
+{
+  auto exit = exit_face(element, r, u);
+  if (exit.first == -1) return {INDEX_NONE, INFTY};
+  return {neighbors_[element][exit.first], exit.second};
+}
+
+std::pair<int, double>
+TetMesh::exit_face(MeshIndex element,
+                   const Position& r,
+                   const Direction& u,
+                   int entry_face) const
+{
+  const auto& connectivity = connectivity_[element];
+  const auto& faces = faces_[element];
+  const MeshIndex* plane_indices = face_planes_ ? face_plane_indices_[element].data() : nullptr;
+  const Vertex v[4] = {vertices_[connectivity[0]],
+                       vertices_[connectivity[1]],
+                       vertices_[connectivity[2]],
+                       vertices_[connectivity[3]]};
+
+  // Plucker products of the ray with each edge. Reversing an edge negates
+  // its product exactly, so each face sees the same values (and the same
+  // tie-breaking) as a separate ray-triangle test of that face.
+  const Direction rayb = cross(u, r);
+  double edges[6];
+  for (int i = 0; i < 6; i++) {
+    edges[i] = plucker_edge_test(v[EDGE_VERTICES[i][0]], v[EDGE_VERTICES[i][1]], u, rayb);
+  }
+  auto edge_product = [&](int a, int b) {
+    return a < b ? edges[EDGE_INDEX[a][b]] : -edges[EDGE_INDEX[b][a]];
+  };
+
+  // distance to the exit point through a face, or -1 if the ray does not leave through it
+  auto exit_distance = [&](int i) {
+    int a = faces[3 * i], b = faces[3 * i + 1], c = faces[3 * i + 2];
+    double plucker_coord0 = edge_product(a, b);
+    double plucker_coord1 = edge_product(b, c);
+    double plucker_coord2 = edge_product(c, a);
+
+    // exiting hits only, face normals point outward with respect to the element
+    if (plucker_coord0 > 0.0 || plucker_coord1 > 0.0 || plucker_coord2 > 0.0) return -1.0;
+    // ray is coplanar with the face
+    if (plucker_coord0 == 0.0 && plucker_coord1 == 0.0 && plucker_coord2 == 0.0) return -1.0;
+
+    // the signs of the products place the ray within the face, leaving only the distance
+    if (plane_indices) return plane_distance(face_planes_[plane_indices[i]], r, u);
+
+    Vertex coords[3] = {v[a], v[b], v[c]};
+    return plucker_intersection_distance(coords, r, u, plucker_coord0, plucker_coord1, plucker_coord2);
+  };
+
+  // choose the exiting face based on the minimum distance
+  int idx_out = -1;
+  double min_dist = INFTY;
+  for (int i = 0; i < 4; i++) {
+    if (i == entry_face) continue;
+    double dist = exit_distance(i);
+    if (dist >= 0.0 && dist < min_dist) {
+      min_dist = dist;
+      idx_out = i;
+    }
+  }
+
+  // a ray grazing the element may only register a hit on the face it entered through
+  if (idx_out == -1 && entry_face != -1) {
+    double dist = exit_distance(entry_face);
+    if (dist >= 0.0) {
+      min_dist = dist;
+      idx_out = entry_face;
+    }
+  }
+
+  return {idx_out, min_dist};
+}
+
+} // namespace xdg
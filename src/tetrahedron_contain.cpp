@@ -1,6 +1,9 @@
 #include "xdg/constants.h"
+#include "xdg/geometry_data.h"
+#include "xdg/primitive_ref.h"
 #include "xdg/ray_tracing_interface.h"
 #include "xdg/ray.h"
+#include "xdg/tetrahedron_contain.h"
 #include "xdg/vec3da.h"
 
 #include "xdg/util/linalg.h"
@@ -8,11 +11,10 @@
 namespace xdg
 {
 
-bool plucker_tet_containment_test(const Position& point,
-                                  const Position& v0,
-                                  const Position& v1,
-                                  const Position& v2,
-                                  const Position& v3) {
+TetTransform tet_transform(const Vertex& v0,
+                           const Vertex& v1,
+                           const Vertex& v2,
+                           const Vertex& v3) {
     using namespace linalg::aliases;
     // Create matrix T = [v1 - v0, v2 - v0, v3 - v0]
     Vec3da e0 = v1 - v0;
@@ -21,18 +23,35 @@ bool plucker_tet_containment_test(const Position& point,
     double3x3 T = { {e0.x, e0.y, e0.z},
                    {e1.x, e1.y, e1.z},
                    {e2.x, e2.y, e2.z}};
+    double3x3 T_inv = inverse(T);
 
+    // matrices are stored by column, gather the rows of the inverse
+    TetTransform transform;
+    for (int i = 0; i < 3; ++i) {
+        transform.origin[i] = v0[i];
+        for (int j = 0; j < 3; ++j) transform.rows[i][j] = T_inv[j][i];
+    }
+    return transform;
+}
+
+bool tet_transform_containment_test(const Position& point,
+                                    const TetTransform& transform) {
     // Vector from v0 to point
-    Vec3da rhs = point - v0;
+    const double rhs[3] = {point.x - transform.origin[0],
+                           point.y - transform.origin[1],
+                           point.z - transform.origin[2]};
 
     // Solve T * [λ1, λ2, λ3] = rhs
-    double3 lambda123 = mul(inverse(T),{rhs.x, rhs.y, rhs.z});
+    auto row_dot = [&](const double* row) { return row[0] * rhs[0] + row[1] * rhs[1] + row[2] * rhs[2]; };
+    double lambda1 = row_dot(transform.rows[0]);
+    double lambda2 = row_dot(transform.rows[1]);
+    double lambda3 = row_dot(transform.rows[2]);
 
     // Compute λ0
-    double lambda0 = 1.0f - (lambda123.x + lambda123.y + lambda123.z);
+    double lambda0 = 1.0f - (lambda1 + lambda2 + lambda3);
 
     // Final barycentric coordinate vector
-    double4 bary = { lambda0, lambda123.x, lambda123.y, lambda123.z };
+    double bary[4] = { lambda0, lambda1, lambda2, lambda3 };
 
     // Check all λ_i in [0, 1]
     for (int i = 0; i < 4; ++i) {
@@ -42,16 +61,28 @@ bool plucker_tet_containment_test(const Position& point,
     return true;
 }
 
+bool plucker_tet_containment_test(const Position& point,
+                                  const Position& v0,
+                                  const Position& v1,
+                                  const Position& v2,
+                                  const Position& v3) {
+    return tet_transform_containment_test(point, tet_transform(v0, v1, v2, v3));
+}
+
 // Embree callbacks
 
 void VolumeElementBoundsFunc(RTCBoundsFunctionArguments* args)
 {
   const VolumeElementsUserData* user_data = (const VolumeElementsUserData*)args->geometryUserPtr;
-  const MeshManager* mesh_manager = user_data->mesh_manager;
-
-  const PrimitiveRef& primitive_ref = user_data->prim_ref_buffer[args->primID];
 
-  BoundingBox bounds = mesh_manager->element_bounding_box(primitive_ref.primitive_id);
+  // copy the bounds computed for all elements up front when available
+  BoundingBox bounds;
+  if (user_data->bounds_buffer) {
+    bounds = user_data->bounds_buffer[args->primID];
+  } else {
+    const PrimitiveRef& primitive_ref = user_data->prim_ref_buffer[args->primID];
+    bounds = user_data->mesh_manager->element_bounding_box(primitive_ref.primitive_id);
+  }
   double bump = bounds.dilation();
 
   args->bounds_o->lower_x = bounds.min_x - bump;
@@ -62,22 +93,25 @@ void VolumeElementBoundsFunc(RTCBoundsFunctionArguments* args)
   args->bounds_o->upper_z = bounds.max_z + bump;
 }
 
+// Test whether a primitive contains a point, using the packed transform cache
+// of the geometry if one is present and the element's vertices otherwise
+inline bool element_contains(const VolumeElementsUserData* user_data, unsigned int primID, const Position& point)
+{
+  if (user_data->transform_buffer) return tet_transform_containment_test(point, user_data->transform_buffer[primID]);
+  auto vertices = user_data->mesh_manager->element_vertices(user_data->prim_ref_buffer[primID].primitive_id);
+  return plucker_tet_containment_test(point, vertices[0], vertices[1], vertices[2], vertices[3]);
+}
+
 void TetrahedronIntersectionFunc(RTCIntersectFunctionNArguments* args) {
   const VolumeElementsUserData* user_data = (const VolumeElementsUserData*)args->geometryUserPtr;
-  const MeshManager* mesh_manager = user_data->mesh_manager;
-
-  // TODO: Update this!
-  const PrimitiveRef primitive_ref = user_data->prim_ref_buffer[args->primID];
-  auto vertices = mesh_manager->element_vertices(primitive_ref.primitive_id);
 
   RTCDualRayHit* rayhit = (RTCDualRayHit*)args->rayhit;
   RTCSurfaceDualRay& ray = rayhit->ray;
-  RTCDualHit& hit = rayhit->hit;
 
   Position ray_origin = {ray.dorg[0], ray.dorg[1], ray.dorg[2]};
 
   // check the containment of the point
-  bool inside = plucker_tet_containment_test(ray_origin, vertices[0], vertices[1], vertices[2], vertices[3]);
+  bool inside = element_contains(user_data, args->primID, ray_origin);
 
   if (!inside) return;
   // zero out the hit information
@@ -94,17 +128,14 @@ void TetrahedronIntersectionFunc(RTCIntersectFunctionNArguments* args) {
 void TetrahedronOcclusionFunc(RTCOccludedFunctionNArguments* args)
 {
   const VolumeElementsUserData* user_data = (const VolumeElementsUserData*)args->geometryUserPtr;
-  const MeshManager* mesh_manager = user_data->mesh_manager;
 
   const PrimitiveRef primitive_ref = user_data->prim_ref_buffer[args->primID];
 
-  auto vertices = mesh_manager->element_vertices(primitive_ref.primitive_id);
-
   RTCElementDualRay* ray = (RTCElementDualRay*)args->ray;
   Position ray_origin = {ray->dorg[0], ray->dorg[1], ray->dorg[2]};
 
   // check the containment of the point
-  bool inside = plucker_tet_containment_test(ray_origin, vertices[0], vertices[1], vertices[2], vertices[3]);
+  bool inside = element_contains(user_data, args->primID, ray_origin);
 
   if (!inside) return;
 
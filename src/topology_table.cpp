@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <numeric>
+
+#include "xdg/topology_table.h"
+
+namespace xdg {
+
+namespace {
+
+// positions of a set of IDs in ascending order of ID
+std::vector<size_t> sorted_order(const std::vector<MeshID>& ids)
+{
+  std::vector<size_t> order(ids.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ids[a] < ids[b]; });
+  return order;
+}
+
+} // namespace
+
+TopologyTable::TopologyTable(const std::vector<MeshID>& volumes,
+                             const std::vector<std::vector<MeshID>>& volume_surfaces,
+                             const std::vector<MeshID>& surfaces,
+                             const std::vector<std::pair<MeshID, MeshID>>& senses)
+{
+  // the block mappings require IDs in ascending order
+  std::vector<MeshID> sorted_ids;
+  for (auto i : sorted_order(surfaces)) {
+    sorted_ids.push_back(surfaces[i]);
+    senses_.push_back(senses[i]);
+  }
+  surface_map_ = IDBlockMapping<MeshID>(sorted_ids);
+
+  sorted_ids.clear();
+  volume_offsets_.assign(1, 0);
+  for (auto i : sorted_order(volumes)) {
+    sorted_ids.push_back(volumes[i]);
+    for (auto surface : volume_surfaces[i]) {
+      volume_surfaces_.push_back(surface);
+      volume_senses_.push_back(surface_sense(surface, volumes[i]));
+    }
+    volume_offsets_.push_back(volume_surfaces_.size());
+  }
+  volume_map_ = IDBlockMapping<MeshID>(sorted_ids);
+}
+
+Sense TopologyTable::surface_sense(MeshID surface, MeshID volume) const
+{
+  auto parents = surface_senses(surface);
+  if (parents.first == volume) return Sense::FORWARD;
+  if (parents.second == volume) return Sense::REVERSE;
+  return Sense::UNSET;
+}
+
+std::vector<MeshID> TopologyTable::volume_surfaces(MeshID volume) const
+{
+  MeshIndex idx = volume_map_.id_to_index(volume);
+  if (idx == INDEX_NONE) return {};
+  return {volume_surfaces_.begin() + volume_offsets_[idx], volume_surfaces_.begin() + volume_offsets_[idx + 1]};
+}
+
+std::vector<Sense> TopologyTable::volume_surface_senses(MeshID volume) const
+{
+  MeshIndex idx = volume_map_.id_to_index(volume);
+  if (idx == INDEX_NONE) return {};
+  return {volume_senses_.begin() + volume_offsets_[idx], volume_senses_.begin() + volume_offsets_[idx + 1]};
+}
+
+} // namespace xdg
@@ -0,0 +1,153 @@
+#include "xdg/track_cursor.h"
+#include "xdg/error.h"
+#include "xdg/ray_history.h"
+#include "xdg/tet_mesh.h"
+#include "xdg/xdg.h"
+
+namespace xdg {
+
+TrackCursor::TrackCursor(std::shared_ptr<const XDG> xdg,
+                         const Position& position,
+                         const Direction& direction)
+  : xdg_(xdg), tet_mesh_(xdg->mesh_manager()->tet_mesh()), direction_(direction)
+{
+  set_position(position);
+}
+
+void TrackCursor::set_position(const Position& position)
+{
+  position_ = position;
+  element_ = xdg_->find_element(position_);
+  element_index_ = tet_mesh_ && element_ != ID_NONE ? tet_mesh_->element_index(element_) : INDEX_NONE;
+  entry_face_ = -1;
+  last_face_ = ID_NONE;
+  volume_known_ = false;
+}
+
+void TrackCursor::set_direction(const Direction& direction)
+{
+  direction_ = direction;
+  // the track no longer leaves the element along the line it entered on
+  entry_face_ = -1;
+}
+
+std::vector<std::pair<MeshID, double>>
+TrackCursor::advance(double distance)
+{
+  std::vector<std::pair<MeshID, double>> result;
+  advance(distance, [&](MeshID element, double length) {
+    result.push_back({element, length});
+    return true;
+  });
+  return result;
+}
+
+MeshID TrackCursor::volume() const
+{
+  const auto& mesh_manager = xdg_->mesh_manager();
+  if (element_ != ID_NONE && mesh_manager->has_volume_tables())
+    return mesh_manager->element_parent_volume(element_);
+
+  // the volume is only located again once the track has moved to another
+  // element or, outside of the mesh, to another position
+  bool moved = volume_element_ != element_ || (element_ == ID_NONE && !(volume_position_ == position_));
+  if (!volume_known_ || moved) {
+    volume_ = xdg_->find_volume(position_, direction_, volume_);
+    volume_element_ = element_;
+    volume_position_ = position_;
+    volume_known_ = true;
+  }
+  return volume_;
+}
+
+PropertyID TrackCursor::material() const
+{
+  return xdg_->mesh_manager()->volume_property_id(volume(), PropertyType::MATERIAL);
+}
+
+bool TrackCursor::step(double& distance, MeshID& element, double& length)
+{
+  if (distance <= 0.0) return false;
+  if (element_ == ID_NONE && !enter_mesh(distance)) return false;
+
+  MeshID next = ID_NONE;
+  MeshIndex next_index = INDEX_NONE;
+  int next_entry_face = -1;
+  double exit_distance;
+  if (element_index_ != INDEX_NONE) {
+    auto exit = tet_mesh_->exit_face(element_index_, position_, direction_, entry_face_);
+    exit_distance = exit.second;
+    if (exit.first != -1) {
+      next_index = tet_mesh_->neighbor(element_index_, exit.first);
+      next_entry_face = tet_mesh_->neighbor_face(element_index_, exit.first);
+      if (next_index != INDEX_NONE) next = tet_mesh_->element_id(next_index);
+    }
+  } else {
+    auto exit = xdg_->mesh_manager()->next_element(element_, position_, direction_);
+    next = exit.first;
+    exit_distance = exit.second;
+  }
+
+  element = element_;
+  // the track ends within the current element, which it remains in
+  if (exit_distance >= distance) {
+    length = distance;
+    position_ += direction_ * distance;
+    distance = 0.0;
+    return true;
+  }
+
+  length = exit_distance;
+  distance -= exit_distance;
+  position_ += direction_ * exit_distance;
+  element_ = next;
+  element_index_ = next_index;
+  entry_face_ = next_entry_face;
+  return true;
+}
+
+bool TrackCursor::enter_mesh(double& distance)
+{
+  const auto& mesh_manager = xdg_->mesh_manager();
+  MeshID ipc = mesh_manager->implicit_complement();
+
+  // fire a ray against the implicit complement
+  RayHistory history;
+  std::pair<double, MeshID> hit {INFTY, ID_NONE};
+  if (ipc != ID_NONE)
+    hit = xdg_->ray_fire_with_history(ipc, position_ + direction_ * TINY_BIT, direction_, INFTY, HitOrientation::EXITING, &history);
+
+  // the track ends before re-entering the mesh
+  if (hit.second == ID_NONE || hit.first > distance) {
+    position_ += direction_ * distance;
+    distance = 0.0;
+    return false;
+  }
+
+  // move up to the surface
+  double hit_distance = hit.first + TINY_BIT;
+  position_ += direction_ * hit_distance;
+  distance -= hit_distance;
+
+  // get the element on the other side of the hit face using adjacencies
+  element_ = mesh_manager->get_boundary_face_element(history.back());
+  if (element_ == ID_NONE) {
+    warning("Ray fire hit surface {}, but no adjacent elements were found on the other side of the surface.", hit.second);
+    position_ += direction_ * distance;
+    distance = 0.0;
+    return false;
+  }
+  element_index_ = tet_mesh_ ? tet_mesh_->element_index(element_) : INDEX_NONE;
+  entry_face_ = -1;
+  last_face_ = history.back();
+
+  // the volume entered is the one on the other side of the surface from the implicit complement
+  volume_ = mesh_manager->next_volume(ipc, hit.second);
+  volume_element_ = element_;
+  volume_position_ = position_;
+  volume_known_ = true;
+
+  return distance > 0.0;
+}
+
+} // namespace xdg
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cmath>
+
+#include "xdg/track_length_tally.h"
+#include "xdg/config.h"
+#include "xdg/error.h"
+#include "xdg/xdg.h"
+
+#ifdef XDG_HAVE_OPENMP
+#include "omp.h"
+#endif
+
+namespace xdg {
+
+namespace {
+
+inline int thread_num()
+{
+#ifdef XDG_HAVE_OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+inline int num_threads()
+{
+#ifdef XDG_HAVE_OPENMP
+  return omp_get_num_threads();
+#else
+  return 1;
+#endif
+}
+
+// Add a value to a sum, accumulating the rounding error of the addition in a
+// separate correction term (Neumaier's variant of Kahan summation)
+inline void compensated_add(double& sum, double& compensation, double value)
+{
+  double t = sum + value;
+  if (std::abs(sum) >= std::abs(value))
+    compensation += (sum - t) + value;
+  else
+    compensation += (value - t) + sum;
+  sum = t;
+}
+
+} // namespace
+
+TrackLengthTally::TrackLengthTally(std::shared_ptr<const XDG> xdg,
+                                   Mode mode,
+                                   bool compensated)
+  : xdg_(xdg), mode_(mode), compensated_(compensated)
+{
+  size_t n_elements = xdg_->mesh_manager()->num_volume_elements();
+  sums_.resize(n_elements, 0.0);
+  if (compensated_) compensations_.resize(n_elements, 0.0);
+
+  if (mode_ == Mode::AUTO) {
+    size_t n_threads = std::max(XDGConfig::config().n_threads(), 1);
+    size_t buffer_bytes = n_threads * n_elements * sizeof(double) * (compensated_ ? 2 : 1);
+    mode_ = compensated_ || buffer_bytes <= MAX_THREAD_LOCAL_BYTES ? Mode::THREAD_LOCAL : Mode::ATOMIC;
+    if (compensated_ && buffer_bytes > MAX_THREAD_LOCAL_BYTES)
+      warning("Compensated track-length tally buffers need {} bytes, more than the {} byte limit "
+              "for thread-local buffers, as compensation is not available with atomic updates",
+              buffer_bytes, MAX_THREAD_LOCAL_BYTES);
+  }
+
+  if (mode_ == Mode::ATOMIC && compensated_)
+    fatal_error("Compensated summation requires thread-local track-length tally buffers");
+}
+
+void TrackLengthTally::score(size_t n_tracks,
+                             const Position* starts,
+                             const Position* ends,
+                             const double* weights)
+{
+  if (mode_ == Mode::ATOMIC)
+    score_atomic(n_tracks, starts, ends, weights);
+  else
+    score_thread_local(n_tracks, starts, ends, weights);
+}
+
+void TrackLengthTally::score_thread_local(size_t n_tracks,
+                                          const Position* starts,
+                                          const Position* ends,
+                                          const double* weights)
+{
+  const MeshManager* mesh_manager = xdg_->mesh_manager().get();
+  size_t n_elements = sums_.size();
+  bool parallel = xdg_->ray_tracing_interface()->concurrent_queries();
+
+  #pragma omp parallel if(parallel)
+  {
+    #pragma omp single
+    {
+      if (thread_buffers_.size() < static_cast<size_t>(num_threads())) thread_buffers_.resize(num_threads());
+    }
+
+    // buffers are allocated by the thread using them and reused by later batches
+    ThreadBuffer& buffer = thread_buffers_[thread_num()];
+    if (buffer.sums.size() != n_elements) {
+      buffer.sums.assign(n_elements, 0.0);
+      buffer.compensations.assign(compensated_ ? n_elements : 0, 0.0);
+    }
+
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t i = 0; i < n_tracks; ++i) {
+      double weight = weights ? weights[i] : 1.0;
+      xdg_->segments(starts[i], ends[i], [&](MeshID element, double length) {
+        MeshIndex idx = mesh_manager->element_index(element);
+        // an element may be recorded more than once if its sum returns to
+        // zero, which the merge below tolerates
+        if (buffer.sums[idx] == 0.0) buffer.touched.push_back(idx);
+        if (compensated_)
+          compensated_add(buffer.sums[idx], buffer.compensations[idx], weight * length);
+        else
+          buffer.sums[idx] += weight * length;
+        return true;
+      });
+    }
+
+    // merge the elements this thread scored into the results, zeroing the
+    // buffer for the next batch
+    #pragma omp critical
+    {
+      for (MeshIndex idx : buffer.touched) {
+        if (compensated_) {
+          compensated_add(sums_[idx], compensations_[idx], buffer.sums[idx]);
+          compensated_add(sums_[idx], compensations_[idx], buffer.compensations[idx]);
+          buffer.compensations[idx] = 0.0;
+        } else {
+          sums_[idx] += buffer.sums[idx];
+        }
+        buffer.sums[idx] = 0.0;
+      }
+    }
+    buffer.touched.clear();
+  }
+}
+
+void TrackLengthTally::score_atomic(size_t n_tracks,
+                                    const Position* starts,
+                                    const Position* ends,
+                                    const double* weights)
+{
+  const MeshManager* mesh_manager = xdg_->mesh_manager().get();
+  double* sums = sums_.data();
+  bool parallel = xdg_->ray_tracing_interface()->concurrent_queries();
+
+  #pragma omp parallel for schedule(dynamic, 64) if(parallel)
+  for (size_t i = 0; i < n_tracks; ++i) {
+    double weight = weights ? weights[i] : 1.0;
+    xdg_->segments(starts[i], ends[i], [&](MeshID element, double length) {
+      MeshIndex idx = mesh_manager->element_index(element);
+      #pragma omp atomic
+      sums[idx] += weight * length;
+      return true;
+    });
+  }
+}
+
+void TrackLengthTally::reset()
+{
+  std::fill(sums_.begin(), sums_.end(), 0.0);
+  std::fill(compensations_.begin(), compensations_.end(), 0.0);
+}
+
+std::vector<double> TrackLengthTally::results() const
+{
+  std::vector<double> results = sums_;
+  for (size_t i = 0; i < compensations_.size(); ++i) results[i] += compensations_[i];
+  return results;
+}
+
+double TrackLengthTally::result(MeshID element) const
+{
+  MeshIndex idx = xdg_->mesh_manager()->element_index(element);
+  if (idx == INDEX_NONE) fatal_error("Element {} is not a volume element of the tallied mesh", element);
+  return compensated_ ? sums_[idx] + compensations_[idx] : sums_[idx];
+}
+
+} // namespace xdg
@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XDG_TREE_CACHE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "xdg/tree_cache.h"
+#include "xdg/error.h"
+#include "xdg/mesh_manager_interface.h"
+
+namespace xdg {
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'X', 'D', 'G', 'T', 'R', 'E', 'E', '\0'};
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t key;
+  uint64_t n_surfaces;
+  uint64_t n_faces;
+  uint64_t n_volumes;
+  uint64_t n_elements;
+};
+
+struct CacheIndexEntry {
+  int64_t id;
+  uint64_t offset;
+  uint64_t count;
+};
+
+// Offsets of each section of a cache image. Sections are 8-byte aligned.
+struct CacheLayout {
+  size_t surfaces;
+  size_t volumes;
+  size_t face_ids;
+  size_t face_coords;
+  size_t element_ids;
+  size_t size;
+};
+
+size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+CacheLayout cache_layout(const CacheHeader& header)
+{
+  CacheLayout layout;
+  layout.surfaces = align8(sizeof(CacheHeader));
+  layout.volumes = layout.surfaces + header.n_surfaces * sizeof(CacheIndexEntry);
+  layout.face_ids = layout.volumes + header.n_volumes * sizeof(CacheIndexEntry);
+  layout.face_coords = align8(layout.face_ids + header.n_faces * sizeof(MeshID));
+  layout.element_ids = layout.face_coords + header.n_faces * 9 * sizeof(double);
+  layout.size = align8(layout.element_ids + header.n_elements * sizeof(MeshID));
+  return layout;
+}
+
+} // namespace
+
+TreeCache::~TreeCache()
+{
+#ifdef XDG_TREE_CACHE_MMAP
+  if (mapping_) munmap(mapping_, mapping_size_);
+#endif
+}
+
+void TreeCache::hash_bytes(uint64_t& key, const void* data, size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    key ^= bytes[i];
+    key *= 1099511628211ULL;
+  }
+}
+
+uint64_t TreeCache::compute_key(const std::string& mesh_file, MeshLibrary mesh_library, uint64_t build_key)
+{
+  // the mesh file is identified by its size and modification time so that
+  // computing the key doesn't require reading the file
+  std::error_code ec;
+  uint64_t file_size = std::filesystem::file_size(mesh_file, ec);
+  if (ec) fatal_error("Could not read the size of mesh file '{}' to compute the tree cache key", mesh_file);
+  int64_t mtime = std::filesystem::last_write_time(mesh_file, ec).time_since_epoch().count();
+  if (ec) fatal_error("Could not read the modification time of mesh file '{}' to compute the tree cache key", mesh_file);
+
+  int32_t library = static_cast<int32_t>(mesh_library);
+  return hash_values(HASH_SEED, file_size, mtime, library, VERSION, build_key);
+}
+
+std::shared_ptr<TreeCache> TreeCache::from_mesh(const MeshManager& mesh_manager, uint64_t key)
+{
+  const auto& surfaces = mesh_manager.surfaces();
+  const auto& volumes = mesh_manager.volumes();
+
+  std::vector<std::vector<MeshID>> surface_faces(surfaces.size());
+  std::vector<std::vector<MeshID>> volume_elements(volumes.size());
+
+  CacheHeader header;
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = VERSION;
+  header.reserved = 0;
+  header.key = key;
+  header.n_surfaces = surfaces.size();
+  header.n_volumes = volumes.size();
+  header.n_faces = 0;
+  header.n_elements = 0;
+  for (size_t i = 0; i < surfaces.size(); ++i) {
+    surface_faces[i] = mesh_manager.get_surface_faces(surfaces[i]);
+    header.n_faces += surface_faces[i].size();
+  }
+  for (size_t i = 0; i < volumes.size(); ++i) {
+    volume_elements[i] = mesh_manager.get_volume_elements(volumes[i]);
+    header.n_elements += volume_elements[i].size();
+  }
+
+  CacheLayout layout = cache_layout(header);
+  std::shared_ptr<TreeCache> cache(new TreeCache());
+  cache->buffer_.resize(layout.size, 0);
+  char* data = cache->buffer_.data();
+  std::memcpy(data, &header, sizeof(header));
+
+  auto surface_entries = reinterpret_cast<CacheIndexEntry*>(data + layout.surfaces);
+  auto face_ids = reinterpret_cast<MeshID*>(data + layout.face_ids);
+  auto face_coords = reinterpret_cast<double*>(data + layout.face_coords);
+  size_t offset = 0;
+  for (size_t i = 0; i < surfaces.size(); ++i) {
+    surface_entries[i] = {surfaces[i], offset, surface_faces[i].size()};
+    for (auto face : surface_faces[i]) {
+      face_ids[offset] = face;
+      auto vertices = mesh_manager.face_vertices(face);
+      for (int j = 0; j < 3; ++j) {
+        face_coords[9 * offset + 3 * j] = vertices[j].x;
+        face_coords[9 * offset + 3 * j + 1] = vertices[j].y;
+        face_coords[9 * offset + 3 * j + 2] = vertices[j].z;
+      }
+      offset++;
+    }
+  }
+
+  auto volume_entries = reinterpret_cast<CacheIndexEntry*>(data + layout.volumes);
+  auto element_ids = reinterpret_cast<MeshID*>(data + layout.element_ids);
+  offset = 0;
+  for (size_t i = 0; i < volumes.size(); ++i) {
+    volume_entries[i] = {volumes[i], offset, volume_elements[i].size()};
+    std::copy(volume_elements[i].begin(), volume_elements[i].end(), element_ids + offset);
+    offset += volume_elements[i].size();
+  }
+
+  cache->parse(data, layout.size);
+  return cache;
+}
+
+std::shared_ptr<TreeCache> TreeCache::open(const std::string& path, uint64_t key)
+{
+  std::shared_ptr<TreeCache> cache(new TreeCache());
+  const char* data {nullptr};
+  size_t size {0};
+
+#ifdef XDG_TREE_CACHE_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return nullptr;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(CacheHeader)) {
+    close(fd);
+    return nullptr;
+  }
+  size = file_stat.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) return nullptr;
+  cache->mapping_ = mapping;
+  cache->mapping_size_ = size;
+  data = static_cast<const char*>(mapping);
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) return nullptr;
+  size = file.tellg();
+  if (size < sizeof(CacheHeader)) return nullptr;
+  cache->buffer_.resize(size);
+  file.seekg(0);
+  file.read(cache->buffer_.data(), size);
+  data = cache->buffer_.data();
+#endif
+
+  // caches written by another version or for another mesh can't be used
+  CacheHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+      (header.version != VERSION || header.key != key)) return nullptr;
+
+  if (!cache->parse(data, size)) {
+    warning("Ignoring malformed tree cache file '{}'", path);
+    return nullptr;
+  }
+  return cache;
+}
+
+void TreeCache::write(const std::string& path) const
+{
+  const char* data = mapping_ ? static_cast<const char*>(mapping_) : buffer_.data();
+  size_t size = mapping_ ? mapping_size_ : buffer_.size();
+
+  // write to a temporary file and move it into place so that concurrent
+  // readers never see a partially written cache
+#ifdef XDG_TREE_CACHE_MMAP
+  std::string tmp_path = fmt::format("{}.{}.tmp", path, getpid());
+#else
+  std::string tmp_path = fmt::format("{}.{}.tmp", path, static_cast<const void*>(this));
+#endif
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file) fatal_error("Could not open tree cache file '{}' for writing", tmp_path);
+    file.write(data, size);
+    if (!file) fatal_error("Failed to write tree cache file '{}'", tmp_path);
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+    fatal_error("Failed to move tree cache file into place at '{}'", path);
+}
+
+bool TreeCache::parse(const char* data, size_t size)
+{
+  if (size < sizeof(CacheHeader)) return false;
+  CacheHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) return false;
+  if (header.version != VERSION) return false;
+
+  CacheLayout layout = cache_layout(header);
+  if (layout.size > size) return false;
+
+  key_ = header.key;
+  n_faces_ = header.n_faces;
+  n_elements_ = header.n_elements;
+  face_ids_ = reinterpret_cast<const MeshID*>(data + layout.face_ids);
+  face_coords_ = reinterpret_cast<const double*>(data + layout.face_coords);
+  element_ids_ = reinterpret_cast<const MeshID*>(data + layout.element_ids);
+
+  auto surface_entries = reinterpret_cast<const CacheIndexEntry*>(data + layout.surfaces);
+  for (size_t i = 0; i < header.n_surfaces; ++i) {
+    const auto& entry = surface_entries[i];
+    if (entry.offset + entry.count > header.n_faces) return false;
+    surface_index_[entry.id] = {entry.offset, entry.count};
+  }
+
+  auto volume_entries = reinterpret_cast<const CacheIndexEntry*>(data + layout.volumes);
+  for (size_t i = 0; i < header.n_volumes; ++i) {
+    const auto& entry = volume_entries[i];
+    if (entry.offset + entry.count > header.n_elements) return false;
+    volume_index_[entry.id] = {entry.offset, entry.count};
+  }
+  return true;
+}
+
+bool TreeCache::matches(const MeshManager& mesh_manager) const
+{
+  const auto& surfaces = mesh_manager.surfaces();
+  const auto& volumes = mesh_manager.volumes();
+  if (surfaces.size() != num_surfaces() || volumes.size() != num_volumes()) return false;
+
+  size_t n_faces = 0;
+  for (auto surface : surfaces) {
+    auto it = surface_index_.find(surface);
+    if (it == surface_index_.end()) return false;
+    const Range& range = it->second;
+    if (static_cast<size_t>(mesh_manager.num_surface_faces(surface)) != range.count) return false;
+    n_faces += range.count;
+    if (range.count == 0) continue;
+    // the face lists are in primitive order, compare their ends
+    auto faces = mesh_manager.get_surface_faces(surface);
+    if (faces.front() != face_ids_[range.offset] ||
+        faces.back() != face_ids_[range.offset + range.count - 1]) return false;
+  }
+
+  size_t n_elements = 0;
+  for (auto volume : volumes) {
+    auto it = volume_index_.find(volume);
+    if (it == volume_index_.end()) return false;
+    if (static_cast<size_t>(mesh_manager.num_volume_elements(volume)) != it->second.count) return false;
+    n_elements += it->second.count;
+  }
+
+  return n_faces == n_faces_ && n_elements == n_elements_;
+}
+
+MeshIDSpan TreeCache::surface_faces(MeshID surface) const
+{
+  const Range& range = surface_index_.at(surface);
+  return {face_ids_ + range.offset, range.count};
+}
+
+std::array<Vertex, 3> TreeCache::face_vertices(MeshID surface, size_t i) const
+{
+  const double* coords = face_coords_ + 9 * (surface_index_.at(surface).offset + i);
+  return {Vertex(coords[0], coords[1], coords[2]),
+          Vertex(coords[3], coords[4], coords[5]),
+          Vertex(coords[6], coords[7], coords[8])};
+}
+
+MeshIDSpan TreeCache::volume_elements(MeshID volume) const
+{
+  const Range& range = volume_index_.at(volume);
+  return {element_ids_ + range.offset, range.count};
+}
+
+} // namespace xdg
@@ -1,6 +1,9 @@
 #include <algorithm> // for find
+#include <cmath>
+#include <limits>
 
 #include "xdg/geometry/closest.h"
+#include "xdg/geometry/face_common.h"
 #include "xdg/primitive_ref.h"
 #include "xdg/geometry_data.h"
 #include "xdg/geometry/plucker.h"
@@ -24,22 +27,40 @@ bool orientation_cull(const Direction& ray_dir, const Direction& normal, HitOrie
 }
 
 bool primitive_mask_cull(RTCDualRayHit* rayhit, int primID) {
-  if (!rayhit->ray.exclude_primitives) return false;
-
   RTCSurfaceDualRay& ray = rayhit->ray;
-  RTCDualHit& hit = rayhit->hit;
+
+  // the ray history is bounded in size, check it first
+  if (ray.history && ray.history->contains(primID)) return true;
+
+  if (!ray.exclude_primitives) return false;
 
   // if the primitive mask is set, cull if the primitive is not in the mask
   return std::find(ray.exclude_primitives->begin(), ray.exclude_primitives->end(), primID) != ray.exclude_primitives->end();
 }
 
+// Retrieve the vertices of a primitive, reading from the packed vertex cache of
+// the geometry if one is present and from the mesh manager otherwise
+inline std::array<Vertex, 3> primitive_vertices(const SurfaceUserData* user_data, unsigned int primID)
+{
+  if (user_data->vertex_buffer) return user_data->vertex_buffer[primID];
+  return user_data->mesh_manager->face_vertices(user_data->prim_ref_buffer[primID].primitive_id);
+}
+
+// Retrieve the plane of a primitive from the plane cache of the geometry if
+// one is present, computing it from the primitive's vertices otherwise
+inline FacePlane primitive_plane(const SurfaceUserData* user_data,
+                                 unsigned int primID,
+                                 const std::array<Vertex, 3>& vertices)
+{
+  if (user_data->plane_buffer) return user_data->plane_buffer[primID];
+  return triangle_plane(vertices);
+}
+
 void TriangleBoundsFunc(RTCBoundsFunctionArguments* args)
 {
   const SurfaceUserData* user_data = (const SurfaceUserData*)args->geometryUserPtr;
-  const MeshManager* mesh_manager = user_data->mesh_manager;
 
-  const PrimitiveRef& primitive_ref = user_data->prim_ref_buffer[args->primID];
-  BoundingBox bounds = mesh_manager->face_bounding_box(primitive_ref.primitive_id);
+  BoundingBox bounds = BoundingBox::from_points(primitive_vertices(user_data, args->primID));
 
   args->bounds_o->lower_x = bounds.min_x - user_data->box_bump;
   args->bounds_o->lower_y = bounds.min_y - user_data->box_bump;
@@ -49,17 +70,54 @@ void TriangleBoundsFunc(RTCBoundsFunctionArguments* args)
   args->bounds_o->upper_z = bounds.max_z + user_data->box_bump;
 }
 
+// Apply the orientation and primitive filters to a candidate hit and, if it
+// passes, record it on the ray. Returns true if the hit was accepted.
+bool accept_triangle_hit(const SurfaceUserData* user_data,
+                         unsigned int primID,
+                         unsigned int geomID,
+                         Direction normal,
+                         double dist,
+                         RTCDualRayHit* rayhit)
+{
+  const PrimitiveRef& primitive_ref = user_data->prim_ref_buffer[primID];
+  RTCSurfaceDualRay& ray = rayhit->ray;
+
+  // Check if ray is entering or exiting the volume it was fired against
+  // if this is a normal ray fire, flip the normal as needed
+  if (ray.volume_tree == user_data->reverse_vol && rayhit->ray.rf_type != RayFireType::FIND_VOLUME)
+  {  
+    normal = -normal;
+  }
+
+  if (rayhit->ray.rf_type == RayFireType::VOLUME) {
+   if (orientation_cull(rayhit->ray.ddir, normal, rayhit->ray.orientation)) return false;
+   if (primitive_mask_cull(rayhit, primitive_ref.primitive_id)) return false;
+  }
+
+  // if we've gotten through all of the filters, set the ray information
+  rayhit->ray.set_tfar(dist);
+  // zero-out barycentric coords
+  rayhit->hit.u = 0.0;
+  rayhit->hit.v = 0.0;
+  rayhit->hit.Ng_x = 0.0;
+  rayhit->hit.Ng_y = 0.0;
+  rayhit->hit.Ng_z = 0.0;
+  // set the hit information
+  rayhit->hit.geomID = geomID;
+  rayhit->hit.primID = primID;
+  rayhit->hit.primitive_ref = &primitive_ref;
+  rayhit->hit.surface = user_data->surface_id;
+  rayhit->hit.dNg = normal;
+  return true;
+}
+
 void TriangleIntersectionFunc(RTCIntersectFunctionNArguments* args) {
   const SurfaceUserData* user_data = (const SurfaceUserData*)args->geometryUserPtr;
-  const MeshManager* mesh_manager = user_data->mesh_manager;
 
-  const PrimitiveRef& primitive_ref = user_data->prim_ref_buffer[args->primID];
-
-  auto vertices = mesh_manager->face_vertices(primitive_ref.primitive_id);
+  auto vertices = primitive_vertices(user_data, args->primID);
 
   RTCDualRayHit* rayhit = (RTCDualRayHit*)args->rayhit;
   RTCSurfaceDualRay& ray = rayhit->ray;
-  RTCDualHit& hit = rayhit->hit;
 
   Position ray_origin = {ray.dorg[0], ray.dorg[1], ray.dorg[2]};
   Direction ray_direction = {ray.ddir[0], ray.ddir[1], ray.ddir[2]};
@@ -77,35 +135,64 @@ void TriangleIntersectionFunc(RTCIntersectFunctionNArguments* args) {
 
   if (plucker_dist > rayhit->ray.dtfar) return;
 
-  Direction normal = mesh_manager->face_normal(primitive_ref.primitive_id);
+  Direction normal = primitive_plane(user_data, args->primID, vertices).normal;
+  accept_triangle_hit(user_data, args->primID, args->geomID, normal, plucker_dist, rayhit);
+}
 
-  // Check if ray is entering or exiting the volume it was fired against
-  // if this is a normal ray fire, flip the normal as needed
-  if (ray.volume_tree == user_data->reverse_vol && rayhit->ray.rf_type != RayFireType::FIND_VOLUME)
-  {  
-    normal = -normal;
-  }
+// Bound on the error of Embree's single precision distance to a hit at
+// distance dist along a ray. The error of the float test scales with the
+// magnitude of the coordinates involved, which is at most that of the ray
+// origin plus the distance travelled.
+inline double float_distance_tolerance(const RTCSurfaceDualRay& ray, double dist)
+{
+  double extent = dist + std::max({std::abs(ray.dorg[0]), std::abs(ray.dorg[1]), std::abs(ray.dorg[2])});
+  return 8.0 * std::numeric_limits<float>::epsilon() * extent;
+}
 
-  if (rayhit->ray.rf_type == RayFireType::VOLUME) {
-   if (orientation_cull(rayhit->ray.ddir, normal, rayhit->ray.orientation)) return;
-   if (primitive_mask_cull(rayhit, primitive_ref.primitive_id)) return;
+void TriangleIntersectionFilterFunc(const RTCFilterFunctionNArguments* args) {
+  const SurfaceUserData* user_data = (const SurfaceUserData*)args->geometryUserPtr;
+  RTCDualRayHit* rayhit = ((const RTCDualRayQueryContext*)args->context)->rayhit;
+  unsigned int primID = RTCHitN_primID(args->hit, args->N, 0);
+  unsigned int geomID = RTCHitN_geomID(args->hit, args->N, 0);
+
+  // reject the candidate unless it passes the double precision checks below
+  args->valid[0] = 0;
+
+  auto vertices = primitive_vertices(user_data, primID);
+  RTCSurfaceDualRay& ray = rayhit->ray;
+
+  FacePlane plane = primitive_plane(user_data, primID, vertices);
+
+  double dist;
+  auto result = plucker_ray_tri_intersect(vertices.data(),
+                                          ray.dorg,
+                                          ray.ddir,
+                                          ray.dtfar,
+                                          0.0,
+                                          false,
+                                          0);
+  if (result.hit) {
+    dist = result.t;
+  } else {
+    // Embree's watertight single precision test reported a hit that the
+    // double precision test did not (this happens near edges and vertices).
+    // The adjacent triangle may not be reported by Embree at all, so trust the
+    // single precision result and refine the distance against the triangle
+    // plane in double precision to avoid rays leaking between triangles
+    if (ray.ddir.dot(plane.normal) == 0.0) return;
+    dist = plane_distance(plane, ray.dorg, ray.ddir);
+    if (dist < 0.0) return;
   }
 
+  if (dist > ray.dtfar) return;
 
-  // if we've gotten through all of the filters, set the ray information
-  rayhit->ray.set_tfar(plucker_dist);
-  // zero-out barycentric coords
-  rayhit->hit.u = 0.0;
-  rayhit->hit.v = 0.0;
-  rayhit->hit.Ng_x = 0.0;
-  rayhit->hit.Ng_y = 0.0;
-  rayhit->hit.Ng_z = 0.0;
-  // set the hit information
-  rayhit->hit.geomID = args->geomID;
-  rayhit->hit.primID = args->primID;
-  rayhit->hit.primitive_ref = &primitive_ref;
-  rayhit->hit.surface = user_data->surface_id;
-  rayhit->hit.dNg = normal;
+  if (!accept_triangle_hit(user_data, primID, geomID, plane.normal, dist, rayhit)) return;
+
+  args->valid[0] = -1;
+  // Embree culls candidates using the single precision hit distance. Extend it
+  // by the error of that distance so that candidates within the error band of
+  // the single precision test are still passed to this filter and tested exactly
+  RTCRayN_tfar(args->ray, args->N, 0) = std::min(dist + float_distance_tolerance(ray, dist), INFTYF);
 }
 
 bool TriangleClosestFunc(RTCPointQueryFunctionArguments* args) {
@@ -113,10 +200,8 @@ bool TriangleClosestFunc(RTCPointQueryFunctionArguments* args) {
   // get the array of DblTri's stored on the geometry
   const SurfaceUserData* user_data = (const SurfaceUserData*) rtcGetGeometryUserData(g);
 
-  const MeshManager* mesh_manager = user_data->mesh_manager;
-
   const PrimitiveRef& primitive_ref = user_data->prim_ref_buffer[args->primID];
-  auto vertices = mesh_manager->face_vertices(primitive_ref.primitive_id);
+  auto vertices = primitive_vertices(user_data, args->primID);
 
   RTCDPointQuery* query = (RTCDPointQuery*) args->query;
   Position p {query->dblx, query->dbly, query->dblz};
@@ -138,10 +223,8 @@ bool TriangleClosestFunc(RTCPointQueryFunctionArguments* args) {
 
 void TriangleOcclusionFunc(RTCOccludedFunctionNArguments* args) {
   const SurfaceUserData* user_data = (const SurfaceUserData*) args->geometryUserPtr;
-  const MeshManager* mesh_manager = user_data->mesh_manager;
-  const PrimitiveRef& primitive_ref = user_data->prim_ref_buffer[args->primID];
 
-  auto vertices = mesh_manager->face_vertices(primitive_ref.primitive_id);
+  auto vertices = primitive_vertices(user_data, args->primID);
 
   // get the double precision ray from the args
   RTCSurfaceDualRay* ray = (RTCSurfaceDualRay*) args->ray;
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mutex>
 #include <vector>
 #include <numeric>
 
@@ -5,6 +9,7 @@
 #include "xdg/error.h"
 #include "xdg/constants.h"
 #include "xdg/geometry/measure.h"
+#include "xdg/timer.h"
 
 #include "xdg/mesh_managers.h"
 
@@ -12,6 +17,58 @@
 
 namespace xdg {
 
+namespace {
+
+// Compute the segments of a batch of tracks, in parallel unless the ray
+// tracer does not support concurrent queries. The segments of track i are
+// passed to a visitor by calling track_segments(i, visitor).
+template<typename TrackFunc>
+TrackSegments collect_segments(size_t n_tracks, bool parallel, TrackFunc&& track_segments)
+{
+  TrackSegments result;
+  result.offsets.assign(n_tracks + 1, 0);
+  // start of each track's segments in the buffer of the thread that computed it
+  std::vector<size_t> local_offsets(n_tracks);
+
+  #pragma omp parallel if(parallel)
+  {
+    std::vector<size_t> tracks;
+    std::vector<MeshID> elements;
+    std::vector<double> lengths;
+
+    #pragma omp for schedule(dynamic, 16)
+    for (size_t i = 0; i < n_tracks; ++i) {
+      tracks.push_back(i);
+      local_offsets[i] = elements.size();
+      track_segments(i, [&](MeshID element, double length) {
+        elements.push_back(element);
+        lengths.push_back(length);
+        return true;
+      });
+      result.offsets[i + 1] = elements.size() - local_offsets[i];
+    }
+
+    // convert the segment counts to offsets
+    #pragma omp single
+    {
+      for (size_t i = 0; i < n_tracks; ++i) result.offsets[i + 1] += result.offsets[i];
+      result.elements.resize(result.offsets[n_tracks]);
+      result.lengths.resize(result.offsets[n_tracks]);
+    }
+
+    // copy this thread's segments into place
+    for (auto i : tracks) {
+      size_t count = result.offsets[i + 1] - result.offsets[i];
+      std::copy_n(elements.begin() + local_offsets[i], count, result.elements.begin() + result.offsets[i]);
+      std::copy_n(lengths.begin() + local_offsets[i], count, result.lengths.begin() + result.offsets[i]);
+    }
+  }
+
+  return result;
+}
+
+} // namespace
+
 XDG::XDG(std::shared_ptr<MeshManager> mesh_manager, RTLibrary ray_tracing_lib)
         : mesh_manager_(mesh_manager)
 {
@@ -36,14 +93,104 @@ XDG::XDG(std::shared_ptr<MeshManager> mesh_manager, RTLibrary ray_tracing_lib)
 
 void XDG::prepare_raytracer()
 {
-  for (auto volume : mesh_manager()->volumes()) {
-    this->prepare_volume_for_raytracing(volume);
+  prepare_raytracer(TreeOptions());
+}
+
+void XDG::prepare_raytracer(const TreeOptions& options)
+{
+  tree_options_ = options;
+  prepare_timings_ = PrepareTimings();
+
+  Timer total_timer;
+  Timer phase_timer;
+  total_timer.start();
+
+  // read the mesh data used to build trees from the cache, creating it if
+  // it is missing or out of date
+  if (!options.cache_file.empty()) {
+    phase_timer.start();
+    if (options.mesh_file.empty())
+      fatal_error("A mesh file is required to key the tree cache '{}'", options.cache_file);
+    // the cache is only valid for trees built with the same parameters
+    uint64_t build_key = TreeCache::hash_values(ray_tracing_interface()->tree_build_key(), options.face_planes);
+    uint64_t key = TreeCache::compute_key(options.mesh_file, mesh_manager()->mesh_library(), build_key);
+    std::shared_ptr<const TreeCache> cache = TreeCache::open(options.cache_file, key);
+    if (cache && !cache->matches(*mesh_manager())) {
+      warning("Tree cache '{}' does not match the mesh in '{}', rebuilding it", options.cache_file, options.mesh_file);
+      cache = nullptr;
+    }
+    if (!cache) {
+      auto new_cache = TreeCache::from_mesh(*mesh_manager(), key);
+      new_cache->write(options.cache_file);
+      cache = new_cache;
+    }
+    ray_tracing_interface()->set_tree_cache(cache);
+    prepare_timings_.cache = phase_timer.elapsed();
+  }
+
+  // dense element -> volume table for located queries
+  mesh_manager()->build_volume_tables();
+
+  // face planes are read by trees built up front or on demand
+  if (options.face_planes) mesh_manager()->build_face_planes();
+
+  // trees are built by the queries that need them
+  if (options.lazy) {
+    prepare_timings_.total = total_timer.elapsed();
+    return;
   }
 
-  ray_tracing_interface()->create_global_element_tree();
-  ray_tracing_interface()->create_global_surface_tree();
+  // build the surface and element trees of all volumes
+  phase_timer.reset();
+  phase_timer.start();
+  const auto& volumes = mesh_manager()->volumes();
+  if (options.surface_trees && options.element_trees) {
+    auto trees = ray_tracing_interface()->register_volumes(mesh_manager_, volumes);
+    for (size_t i = 0; i < volumes.size(); ++i) {
+      volume_to_surface_tree_map_[volumes[i]] = trees[i].first;
+      volume_to_point_location_tree_map_[volumes[i]] = trees[i].second;
+    }
+  } else {
+    for (auto volume : volumes) {
+      if (options.surface_trees)
+        volume_to_surface_tree_map_[volume] = ray_tracing_interface()->create_surface_tree(mesh_manager_, volume);
+      if (options.element_trees)
+        volume_to_point_location_tree_map_[volume] = ray_tracing_interface()->create_element_tree(mesh_manager_, volume);
+    }
+  }
+  prepare_timings_.volume_trees = phase_timer.elapsed();
+
+  phase_timer.reset();
+  phase_timer.start();
+  if (options.global_trees) {
+    if (options.surface_trees && options.element_trees) {
+      ray_tracing_interface()->create_global_trees();
+    } else if (options.surface_trees) {
+      ray_tracing_interface()->create_global_surface_tree();
+    } else if (options.element_trees) {
+      ray_tracing_interface()->create_global_element_tree();
+    }
+    global_surface_tree_built_ = options.surface_trees;
+    global_element_tree_built_ = options.element_trees;
+  }
+  prepare_timings_.global_trees = phase_timer.elapsed();
 
+  phase_timer.reset();
+  phase_timer.start();
   ray_tracing_interface()->init(); // Initialize the ray tracer (e.g. build SBT for GPRT)
+  prepare_timings_.init = phase_timer.elapsed();
+
+  prepare_timings_.total = total_timer.elapsed();
+}
+
+void XDG::PrepareTimings::write() const
+{
+  write_message("Ray tracer preparation time [s]");
+  write_message("  Tree cache : {:.6f}", cache);
+  write_message("  Volume trees : {:.6f}", volume_trees);
+  write_message("  Global trees : {:.6f}", global_trees);
+  write_message("  Initialization : {:.6f}", init);
+  write_message("  Total : {:.6f}", total);
 }
 
 void XDG::prepare_volume_for_raytracing(MeshID volume) {
@@ -52,6 +199,107 @@ void XDG::prepare_volume_for_raytracing(MeshID volume) {
     volume_to_point_location_tree_map_[volume] = volume_tree;
 }
 
+XDG::TreeLock XDG::lock_trees() const
+{
+  if (!tree_options_.lazy) return TreeLock();
+  return TreeLock(tree_mutex_);
+}
+
+bool XDG::builds_on_demand(bool requested) const
+{
+  return tree_options_.lazy && requested;
+}
+
+template<typename Build>
+void XDG::build_on_demand(TreeLock& lock, Build build) const
+{
+  // Queries hold the lock in shared mode. Builders release it and wait for
+  // exclusive access so that only one thread builds at a time and no query
+  // reads the ray tracer while it is being modified. Builds must check that
+  // the tree is still missing as another thread may have built it while
+  // this one was waiting.
+  lock.unlock();
+  {
+    std::unique_lock<std::shared_mutex> build_lock(tree_mutex_);
+    build();
+    ray_tracing_interface()->init(); // refresh the ray tracer (e.g. rebuild the SBT for GPRT)
+  }
+  lock.lock();
+}
+
+TreeID XDG::surface_tree(MeshID volume, TreeLock& lock) const
+{
+  auto it = volume_to_surface_tree_map_.find(volume);
+  if (it != volume_to_surface_tree_map_.end()) return it->second;
+  if (!builds_on_demand(tree_options_.surface_trees)) return volume_to_surface_tree_map_.at(volume);
+
+  build_on_demand(lock, [&]() {
+    if (volume_to_surface_tree_map_.count(volume)) return;
+    volume_to_surface_tree_map_[volume] = ray_tracing_interface()->create_surface_tree(mesh_manager_, volume);
+  });
+  return volume_to_surface_tree_map_.at(volume);
+}
+
+TreeID XDG::element_tree(MeshID volume, TreeLock& lock) const
+{
+  auto it = volume_to_point_location_tree_map_.find(volume);
+  if (it != volume_to_point_location_tree_map_.end()) return it->second;
+  if (!builds_on_demand(tree_options_.element_trees)) return volume_to_point_location_tree_map_.at(volume);
+
+  build_on_demand(lock, [&]() {
+    if (volume_to_point_location_tree_map_.count(volume)) return;
+    volume_to_point_location_tree_map_[volume] = ray_tracing_interface()->create_element_tree(mesh_manager_, volume);
+  });
+  return volume_to_point_location_tree_map_.at(volume);
+}
+
+void XDG::require_surface_trees(TreeLock& lock) const
+{
+  if (!builds_on_demand(tree_options_.surface_trees)) return;
+  if (volume_to_surface_tree_map_.size() == mesh_manager()->volumes().size()) return;
+
+  build_on_demand(lock, [&]() {
+    for (auto volume : mesh_manager()->volumes()) {
+      if (volume_to_surface_tree_map_.count(volume)) continue;
+      volume_to_surface_tree_map_[volume] = ray_tracing_interface()->create_surface_tree(mesh_manager_, volume);
+    }
+  });
+}
+
+void XDG::require_global_surface_tree(TreeLock& lock) const
+{
+  if (!builds_on_demand(tree_options_.global_trees && tree_options_.surface_trees)) return;
+  if (global_surface_tree_built_) return;
+
+  build_on_demand(lock, [&]() {
+    if (global_surface_tree_built_) return;
+    // the global tree is assembled from the surfaces registered with each volume's tree
+    for (auto volume : mesh_manager()->volumes()) {
+      if (volume_to_surface_tree_map_.count(volume)) continue;
+      volume_to_surface_tree_map_[volume] = ray_tracing_interface()->create_surface_tree(mesh_manager_, volume);
+    }
+    ray_tracing_interface()->create_global_surface_tree();
+    global_surface_tree_built_ = true;
+  });
+}
+
+void XDG::require_global_element_tree(TreeLock& lock) const
+{
+  if (!builds_on_demand(tree_options_.global_trees && tree_options_.element_trees)) return;
+  if (global_element_tree_built_) return;
+
+  build_on_demand(lock, [&]() {
+    if (global_element_tree_built_) return;
+    // the global tree is assembled from the element trees of every volume
+    for (auto volume : mesh_manager()->volumes()) {
+      if (volume_to_point_location_tree_map_.count(volume)) continue;
+      volume_to_point_location_tree_map_[volume] = ray_tracing_interface()->create_element_tree(mesh_manager_, volume);
+    }
+    ray_tracing_interface()->create_global_element_tree();
+    global_element_tree_built_ = true;
+  });
+}
+
 std::shared_ptr<XDG> XDG::create(MeshLibrary mesh_lib, RTLibrary ray_tracing_lib)
 {
   std::shared_ptr<XDG> xdg = std::make_shared<XDG>();
@@ -106,17 +354,45 @@ bool XDG::point_in_volume(MeshID volume,
                           const Direction* direction,
                           const std::vector<MeshID>* exclude_primitives) const
 {
-  TreeID tree = volume_to_surface_tree_map_.at(volume);
+  auto lock = lock_trees();
+  TreeID tree = surface_tree(volume, lock);
   return ray_tracing_interface()->point_in_volume(tree, point, direction, exclude_primitives);
 }
 
+bool XDG::point_in_volume_with_history(MeshID volume,
+                                       const Position point,
+                                       const Direction* direction,
+                                       const RayHistory* history) const
+{
+  auto lock = lock_trees();
+  TreeID tree = surface_tree(volume, lock);
+  return ray_tracing_interface()->point_in_volume_with_history(tree, point, direction, history);
+}
+
 MeshID XDG::find_volume(const Position& point,
-                                                   const Direction& direction) const
+                        const Direction& direction,
+                        MeshID hint) const
 {
   MeshID ipc = mesh_manager()->implicit_complement();
+  auto lock = lock_trees();
+
+  if (hint != ID_NONE && hint != ipc) {
+    if (ray_tracing_interface()->point_in_volume(surface_tree(hint, lock), point, &direction))
+      return hint;
+  }
+
+  require_global_surface_tree(lock);
+  TreeID global_tree = ray_tracing_interface()->global_surface_tree();
+  MeshID volume {ID_NONE};
+  if (global_tree != TREE_NONE &&
+      ray_tracing_interface()->find_volume_by_ray(global_tree, *mesh_manager(), point, direction, volume))
+    return volume;
+
+  // test each volume in turn
+  require_surface_trees(lock);
   for (auto volume_scene_pair : volume_to_surface_tree_map_) {
     MeshID volume = volume_scene_pair.first;
-    if (volume == ipc) continue;
+    if (volume == ipc || volume == hint) continue;
     TreeID scene = volume_scene_pair.second;
     if (ray_tracing_interface()->point_in_volume(scene, point, &direction)) {
       return volume;
@@ -127,103 +403,262 @@ MeshID XDG::find_volume(const Position& point,
   return ipc;
 }
 
+void XDG::point_in_volume_batch(MeshID volume,
+                                size_t n_points,
+                                const Position* points,
+                                const Direction* directions,
+                                PointInVolume* results) const
+{
+  auto lock = lock_trees();
+  TreeID tree = surface_tree(volume, lock);
+  ray_tracing_interface()->point_in_volume_batch(tree, n_points, points, directions, results);
+}
+
+void XDG::find_volume_batch(size_t n_points,
+                            const Position* points,
+                            const Direction* directions,
+                            MeshID* volumes) const
+{
+  MeshID ipc = mesh_manager()->implicit_complement();
+  auto lock = lock_trees();
+
+  // locate each point with rays through the global surface tree, as in
+  // find_volume, keeping the indices of the points this does not resolve
+  std::vector<size_t> remaining;
+  require_global_surface_tree(lock);
+  TreeID global_tree = ray_tracing_interface()->global_surface_tree();
+  if (global_tree != TREE_NONE) {
+    std::unique_ptr<bool[]> resolved(new bool[n_points]);
+    ray_tracing_interface()->find_volume_by_ray_batch(global_tree, *mesh_manager(), n_points,
+                                                      points, directions, volumes, resolved.get());
+    for (size_t i = 0; i < n_points; ++i) {
+      if (!resolved[i]) remaining.push_back(i);
+    }
+  } else {
+    remaining.resize(n_points);
+    std::iota(remaining.begin(), remaining.end(), 0);
+  }
+  if (remaining.empty()) return;
+
+  // points not found in any other volume are in the implicit complement
+  for (auto i : remaining) volumes[i] = ipc;
+
+  // test the unresolved points against each volume in turn
+  std::vector<Position> batch_points;
+  std::vector<Direction> batch_directions;
+  std::vector<PointInVolume> results;
+  require_surface_trees(lock);
+  for (auto volume_scene_pair : volume_to_surface_tree_map_) {
+    if (remaining.empty()) break;
+    MeshID volume = volume_scene_pair.first;
+    if (volume == ipc) continue;
+
+    // gather the remaining points and test them against this volume
+    size_t n_remaining = remaining.size();
+    batch_points.resize(n_remaining);
+    if (directions) batch_directions.resize(n_remaining);
+    for (size_t i = 0; i < n_remaining; ++i) {
+      batch_points[i] = points[remaining[i]];
+      if (directions) batch_directions[i] = directions[remaining[i]];
+    }
+    results.resize(n_remaining);
+    ray_tracing_interface()->point_in_volume_batch(volume_scene_pair.second,
+                                                   n_remaining,
+                                                   batch_points.data(),
+                                                   directions ? batch_directions.data() : nullptr,
+                                                   results.data());
+
+    // record located points and compact the remaining set
+    size_t n_unresolved = 0;
+    for (size_t i = 0; i < n_remaining; ++i) {
+      if (results[i] == INSIDE) volumes[remaining[i]] = volume;
+      else remaining[n_unresolved++] = remaining[i];
+    }
+    remaining.resize(n_unresolved);
+  }
+}
+
 MeshID XDG::find_element(const Position& point) const
 {
+  auto lock = lock_trees();
+  require_global_element_tree(lock);
   return ray_tracing_interface()->find_element(point);
 }
 
 MeshID XDG::find_element(MeshID volume,
                          const Position& point) const
 {
-  TreeID scene = volume_to_point_location_tree_map_.at(volume);
+  auto lock = lock_trees();
+  TreeID scene = element_tree(volume, lock);
   return ray_tracing_interface()->find_element(scene, point);
 }
 
+ElementLocation XDG::element_location(MeshID element) const
+{
+  ElementLocation location;
+  if (element == ID_NONE) return location;
+  location.element = element;
+  location.volume = mesh_manager()->element_parent_volume(element);
+  location.material = mesh_manager()->volume_property_id(location.volume, PropertyType::MATERIAL);
+  return location;
+}
+
+ElementLocation XDG::locate_element(const Position& point) const
+{
+  return element_location(find_element(point));
+}
+
+std::vector<std::pair<ElementLocation, double>>
+XDG::located_segments(const Position& start,
+                      const Position& end) const
+{
+  std::vector<std::pair<ElementLocation, double>> result;
+  segments(start, end, [&](MeshID element, double length) {
+    result.push_back({element_location(element), length});
+    return true;
+  });
+  return result;
+}
+
+size_t XDG::find_element_batch(size_t n_points,
+                               const Position* points,
+                               MeshID* elements,
+                               bool* missed) const
+{
+  auto lock = lock_trees();
+  require_global_element_tree(lock);
+  return ray_tracing_interface()->find_element_batch(n_points, points, elements, missed);
+}
+
+size_t XDG::find_element_batch(MeshID volume,
+                               size_t n_points,
+                               const Position* points,
+                               MeshID* elements,
+                               bool* missed) const
+{
+  auto lock = lock_trees();
+  TreeID tree = element_tree(volume, lock);
+  return ray_tracing_interface()->find_element_batch(tree, n_points, points, elements, missed);
+}
+
+MeshID XDG::track_start_element(Position& r,
+                               const Direction& u,
+                               double& distance,
+                               MeshID last_element,
+                               RayHistory& history,
+                               TreeLock& lock) const
+{
+  // attempt to find an element at the start location
+  MeshID current_element = ray_tracing_interface()->find_element(r);
+  // at this point we may be on the face of an element, if we're declared inside that element, ignore it
+  if (current_element != ID_NONE && current_element != last_element) return current_element;
+
+  // fire a ray against the implicit complement
+  MeshID ipc = mesh_manager()->implicit_complement();
+  TreeID ipc_tree = surface_tree(ipc, lock);
+  auto hit = ray_tracing_interface()->ray_fire_with_history(ipc_tree, r + u * TINY_BIT, u, INFTY, HitOrientation::EXITING, &history);
+  // if there is no entry point or the distance to the surface
+  // is past the end point, return
+  if (hit.second == ID_NONE || hit.first > distance) return ID_NONE;
+
+  double hit_dist = hit.first + TINY_BIT;
+  // move up to the surface
+  r += u * hit_dist;
+  distance -= hit_dist;
+
+  // Get the element on the other side of the hit face using adjacencies
+  auto adjacent_element = mesh_manager()->get_boundary_face_element(history.back());
+  if (adjacent_element == ID_NONE) {
+    warning("Ray fire hit surface {}, but no adjacent elements were found on the other side of the surface.", hit.second);
+    return ID_NONE;
+  }
+  history.clear();
+  return adjacent_element;
+}
+
 std::vector<std::pair<MeshID, double>>
 XDG::segments(const Position& start,
               const Position& end) const
 {
-  MeshID ipc = mesh_manager()->implicit_complement();
+  std::vector<std::pair<MeshID, double>> result;
+  segments(start, end, [&](MeshID element, double length) {
+    result.push_back({element, length});
+    return true;
+  });
+  return result;
+}
 
-  std::vector<MeshID> prev_elements;
-
-  Position r = start;
-  Direction u = end - start;
-  double distance = u.length();
-  u /= distance;
-
-  std::vector<xdg::MeshID> hit_primitives;
-
-  std::vector<std::pair<MeshID, double>> segments;
-  while (distance > 0) {
-    // attempt to find an element at the start location
-    MeshID current_element = ray_tracing_interface()->find_element(r);
-    // at this point we may be on the face of an element, if we're declared inside that element, ignore it
-    if (segments.size() > 0 && current_element == segments.back().first) current_element = ID_NONE;
-    MeshID volume = ID_NONE;
-    if (current_element == ID_NONE) {
-      // fire a ray against the implicit complement
-      auto hit = ray_fire(ipc, r + u * TINY_BIT, u, INFTY, HitOrientation::EXITING, &hit_primitives);
-      // if there is no entry point or the distance to the surface
-      // is past the end point, return
-      if (hit.second == ID_NONE || hit.first > distance) return segments;
-
-      double hit_dist = hit.first + TINY_BIT;
-      // move up to the surface
-      r += u * hit_dist;
-      distance -= hit_dist;
-      // determine the volume we're moving into
-      mesh_manager()->next_volume(ipc, hit.second);
-
-      // Get the element on the other side of the hit face using adjacencies
-      auto adjacent_element = mesh_manager()->get_boundary_face_element(hit_primitives.back());
-      if (adjacent_element == ID_NONE) {
-        warning("Ray fire hit surface {}, but no adjacent elements were found on the other side of the surface.", hit.second);
-        return segments;
-      }
-      current_element = adjacent_element;
-      hit_primitives.clear();
-    }
-    auto vol_segments = mesh_manager()->walk_elements(current_element, r, u, distance);
-    // add to current set of segments
-    segments.insert(segments.end(), vol_segments.begin(), vol_segments.end());
-    double segment_sum = std::accumulate(vol_segments.begin(), vol_segments.end(), 0.0,
-                                         [](double total, const auto& segment) { return total + segment.second; });
-    // upate location of the track start
-    r += u * segment_sum;
-    // decrement distance by total distance traveled in the volume
-    distance -= segment_sum;
-  }
-  return segments;
+TrackSegments XDG::segments_batch(size_t n_tracks,
+                                 const Position* starts,
+                                 const Position* ends) const
+{
+  return collect_segments(n_tracks, ray_tracing_interface()->concurrent_queries(), [&](size_t i, auto&& visitor) {
+    segments(starts[i], ends[i], visitor);
+  });
+}
+
+TrackSegments XDG::volume_segments_batch(size_t n_tracks,
+                                        const Position* starts,
+                                        const Position* ends) const
+{
+  // locate the starting volume of every track together
+  std::vector<Direction> directions(n_tracks);
+  for (size_t i = 0; i < n_tracks; ++i) directions[i] = (ends[i] - starts[i]).normalize();
+  std::vector<MeshID> volumes(n_tracks);
+  find_volume_batch(n_tracks, starts, directions.data(), volumes.data());
+
+  return collect_segments(n_tracks, ray_tracing_interface()->concurrent_queries(), [&](size_t i, auto&& visitor) {
+    volume_segments(volumes[i], starts[i], ends[i], visitor);
+  });
 }
 
 std::vector<std::pair<MeshID, double>>
-XDG::segments(MeshID volume,
-              const Position& start,
-              const Position& end) const
+XDG::volume_segments(const Position& start,
+                     const Position& end) const
+{
+  std::vector<std::pair<MeshID, double>> result;
+  MeshID volume = find_volume(start, (end - start).normalize());
+  volume_segments(volume, start, end, [&](MeshID volume, double length) {
+    result.push_back({volume, length});
+    return true;
+  });
+  return result;
+}
+
+MeshID XDG::volume_track_start_element(MeshID volume,
+                                       Position& r,
+                                       const Direction& u,
+                                       TreeLock& lock) const
 {
-  Position start_copy = start;
-  Direction u = (end - start).normalize();
-  TreeID volume_tree = volume_to_point_location_tree_map_.at(volume);
-  MeshID starting_element = ray_tracing_interface()->find_element(volume_tree, start);
+  TreeID volume_tree = element_tree(volume, lock);
+  MeshID starting_element = ray_tracing_interface()->find_element(volume_tree, r);
+  if (starting_element != ID_NONE) return starting_element;
 
   // if we're outside of the region of interest, determine the distance to an entering intersection
   // with the model
+  auto hit = ray_tracing_interface()->ray_fire(surface_tree(volume, lock), r, u, INFTY, HitOrientation::ENTERING);
+  if (hit.second == ID_NONE) return ID_NONE;
+  // TODO: use mesh adjaccies to find the element on the other side of the hit face
+  starting_element = ray_tracing_interface()->find_element(volume_tree, r + u * (hit.first + TINY_BIT));
   if (starting_element == ID_NONE) {
-    auto hit = ray_fire(volume, start, u, INFTY, HitOrientation::ENTERING);
-    if (hit.second == ID_NONE) return {};
-    // TODO: use mesh adjaccies to find the element on the other side of the hit face
-    starting_element = ray_tracing_interface()->find_element(volume_tree, start + u * (hit.first + TINY_BIT));
-    if (starting_element == ID_NONE) {
-      warning("Ray fire hit surface {}, but could not find element on the other side of the surface.", hit.second);
-      return {};
-    }
-    start_copy += u * hit.first;
+    warning("Ray fire hit surface {}, but could not find element on the other side of the surface.", hit.second);
+    return ID_NONE;
   }
+  r += u * hit.first;
+  return starting_element;
+}
 
-  if (starting_element == ID_NONE) return {};
-  auto segments = mesh_manager()->walk_elements(starting_element, start_copy, end);
-  return segments;
+std::vector<std::pair<MeshID, double>>
+XDG::segments(MeshID volume,
+              const Position& start,
+              const Position& end) const
+{
+  std::vector<std::pair<MeshID, double>> result;
+  segments(volume, start, end, [&](MeshID element, double length) {
+    result.push_back({element, length});
+    return true;
+  });
+  return result;
 }
 
 std::pair<MeshID, double>
@@ -242,21 +677,57 @@ XDG::ray_fire(MeshID volume,
               HitOrientation orientation,
               std::vector<MeshID>* const exclude_primitives) const
 {
-  TreeID scene = volume_to_surface_tree_map_.at(volume);
+  auto lock = lock_trees();
+  TreeID scene = surface_tree(volume, lock);
   return ray_tracing_interface()->ray_fire(scene, origin, direction, dist_limit, orientation, exclude_primitives);
 }
 
+std::pair<double, MeshID>
+XDG::ray_fire_with_history(MeshID volume,
+                           const Position& origin,
+                           const Direction& direction,
+                           const double dist_limit,
+                           HitOrientation orientation,
+                           RayHistory* history) const
+{
+  auto lock = lock_trees();
+  TreeID scene = surface_tree(volume, lock);
+  return ray_tracing_interface()->ray_fire_with_history(scene, origin, direction, dist_limit, orientation, history);
+}
+
+void XDG::ray_fire_batch(size_t n_rays,
+                         const MeshID* volumes,
+                         const Position* origins,
+                         const Direction* directions,
+                         const double* dist_limits,
+                         double* distances,
+                         MeshID* surfaces,
+                         HitOrientation orientation) const
+{
+  // rays in a batch are often grouped by volume, only look up the tree when the volume changes
+  auto lock = lock_trees();
+  std::vector<TreeID> trees(n_rays);
+  for (size_t i = 0; i < n_rays; ++i) {
+    if (i > 0 && volumes[i] == volumes[i-1]) trees[i] = trees[i-1];
+    else trees[i] = surface_tree(volumes[i], lock);
+  }
+  ray_tracing_interface()->ray_fire_batch(n_rays, trees.data(), origins, directions, dist_limits,
+                                          distances, surfaces, orientation);
+}
+
 std::pair<double, MeshID> XDG::closest(MeshID volume,
                                        const Position& origin) const
 {
-  TreeID scene = volume_to_surface_tree_map_.at(volume);
+  auto lock = lock_trees();
+  TreeID scene = surface_tree(volume, lock);
   return ray_tracing_interface()->closest(scene, origin);
 }
 
 double XDG::closest_distance(MeshID volume,
                              const Position& origin) const
 {
-  TreeID scene = volume_to_surface_tree_map_.at(volume);
+  auto lock = lock_trees();
+  TreeID scene = surface_tree(volume, lock);
   return ray_tracing_interface()->closest(scene, origin).first;
 }
 
@@ -265,7 +736,8 @@ bool XDG::occluded(MeshID volume,
               const Direction& direction,
               double& dist) const
 {
-  TreeID scene = volume_to_surface_tree_map_.at(volume);
+  auto lock = lock_trees();
+  TreeID scene = surface_tree(volume, lock);
   return ray_tracing_interface()->occluded(scene, origin, direction, dist);
 }
 
@@ -273,12 +745,23 @@ Direction XDG::surface_normal(MeshID surface,
                               Position point,
                               const std::vector<MeshID>* exclude_primitives) const
 {
-  MeshID element;
   if (exclude_primitives != nullptr && exclude_primitives->size() > 0) {
-    element = exclude_primitives->back();
+    return mesh_manager()->face_normal(exclude_primitives->back());
+  }
+  return surface_normal_with_history(surface, point, nullptr);
+}
+
+Direction XDG::surface_normal_with_history(MeshID surface,
+                                           Position point,
+                                           const RayHistory* history) const
+{
+  MeshID element;
+  if (history != nullptr && !history->empty()) {
+    element = history->back();
   } else {
     auto surface_vols = mesh_manager()->get_parent_volumes(surface);
-    TreeID scene = volume_to_surface_tree_map_.at(surface_vols.first);
+    auto lock = lock_trees();
+    TreeID scene = surface_tree(surface_vols.first, lock);
     element = ray_tracing_interface()->closest(scene, point).second;
 
     // TODO: bring this back when we have a better way to handle this
@@ -5,6 +5,7 @@
 #include "xdg/constants.h"
 #include "xdg/mesh_manager_interface.h"
 #include "xdg/embree/ray_tracer.h"
+#include "xdg/xdg.h"
 
 #include "mesh_mock.h"
 
@@ -42,4 +43,125 @@ TEST_CASE("Test Find Volumetric Element")
   REQUIRE(element_id == ID_NONE); // should not find an element since the point is outside the volume
 }
 
+TEST_CASE("Test Batched Find Volumetric Element")
+{
+  std::shared_ptr<MeshManager> mm = std::make_shared<MeshMock>();
+  mm->init();
+
+  auto xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+
+  // sample points inside of the mesh bounding box along with some outside of it
+  BoundingBox bbox = mm->global_bounding_box();
+  size_t n_points = 1000;
+  std::vector<Position> points(n_points);
+  for (size_t i = 0; i < n_points; ++i) {
+    points[i] = bbox.sample_location();
+    if (i % 10 == 0) points[i] += Vec3da {100.0, 0.0, 0.0};
+  }
+
+  std::vector<MeshID> elements(n_points);
+  std::unique_ptr<bool[]> missed(new bool[n_points]);
+  size_t n_missed = xdg->find_element_batch(n_points, points.data(), elements.data(), missed.get());
+  REQUIRE(n_missed == n_points / 10);
+
+  for (size_t i = 0; i < n_points; ++i) {
+    REQUIRE(elements[i] == xdg->find_element(points[i]));
+    REQUIRE(missed[i] == (elements[i] == ID_NONE));
+    REQUIRE(missed[i] == (i % 10 == 0));
+  }
+
+  // the per-volume batch should produce the same elements
+  std::vector<MeshID> volume_elements(n_points);
+  n_missed = xdg->find_element_batch(mm->volumes()[0], n_points, points.data(), volume_elements.data());
+  REQUIRE(n_missed == n_points / 10);
+  REQUIRE(volume_elements == elements);
+}
+
+TEST_CASE("Test Find Element with Tetrahedron Transform Cache")
+{
+  std::shared_ptr<MeshManager> mm = std::make_shared<MeshMock>();
+  mm->init();
+
+  // element trees with and without the cached barycentric transforms
+  auto cached = std::make_shared<EmbreeRayTracer>();
+  auto uncached = std::make_shared<EmbreeRayTracer>();
+  uncached->set_cache_tet_transforms(false);
+  MeshID volume = mm->volumes()[0];
+  TreeID cached_tree = cached->create_element_tree(mm, volume);
+  TreeID uncached_tree = uncached->create_element_tree(mm, volume);
+
+  // 12 doubles for each of the 12 elements
+  REQUIRE(cached->tet_transform_cache_size() == 12 * 12 * sizeof(double));
+  REQUIRE(uncached->tet_transform_cache_size() == 0);
+
+  BoundingBox bbox = mm->global_bounding_box();
+  for (int i = 0; i < 1000; ++i) {
+    Position point = bbox.sample_location();
+    if (i % 10 == 0) point += Vec3da {100.0, 0.0, 0.0};
+    MeshID element = cached->find_element(cached_tree, point);
+    REQUIRE(element == uncached->find_element(uncached_tree, point));
+    REQUIRE((element == ID_NONE) == (i % 10 == 0));
+  }
+}
+
+TEST_CASE("Test Bulk Element Bounding Boxes")
+{
+  std::shared_ptr<MeshManager> mm = std::make_shared<MeshMock>();
+  mm->init();
+  auto elements = mm->get_volume_elements(mm->volumes()[0]);
+
+  // bounds computed from the mesh and from the flat tet mesh agree
+  for (bool flat : {false, true}) {
+    if (flat) mm->build_tet_mesh();
+    auto bounds = mm->element_bounding_boxes(elements);
+    REQUIRE(bounds.size() == elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) {
+      BoundingBox expected = BoundingBox::from_points(mm->element_vertices(elements[i]));
+      REQUIRE(bounds[i].min_x == expected.min_x);
+      REQUIRE(bounds[i].min_y == expected.min_y);
+      REQUIRE(bounds[i].min_z == expected.min_z);
+      REQUIRE(bounds[i].max_x == expected.max_x);
+      REQUIRE(bounds[i].max_y == expected.max_y);
+      REQUIRE(bounds[i].max_z == expected.max_z);
+    }
+  }
+}
 
+TEST_CASE("Test Locate Element with Volume Tables")
+{
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+  REQUIRE(mm->has_volume_tables());
+
+  MeshID volume = mm->volumes()[0];
+  for (auto element : mm->get_volume_elements(volume))
+    REQUIRE(mm->element_parent_volume(element) == volume);
+  REQUIRE(mm->element_parent_volume(ID_NONE) == ID_NONE);
+
+  // the mock assigns no materials
+  REQUIRE(mm->volume_property_id(volume, PropertyType::MATERIAL) == PROPERTY_NONE);
+
+  Position point_inside {0.0, 0.0, 0.0};
+  auto location = xdg->locate_element(point_inside);
+  REQUIRE(location.element == xdg->find_element(point_inside));
+  REQUIRE(location.volume == volume);
+  REQUIRE(location.material == PROPERTY_NONE);
+
+  location = xdg->locate_element({10.0, 10.0, 10.0});
+  REQUIRE(location.element == ID_NONE);
+  REQUIRE(location.volume == ID_NONE);
+
+  // located segments carry the volume of each element
+  Position start {-1.5, 0.5, 0.25};
+  Position end {4.5, 1.0, 0.5};
+  auto expected = xdg->segments(start, end);
+  auto located = xdg->located_segments(start, end);
+  REQUIRE(located.size() == expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    REQUIRE(located[i].first.element == expected[i].first);
+    REQUIRE(located[i].first.volume == volume);
+    REQUIRE(located[i].second == expected[i].second);
+  }
+}
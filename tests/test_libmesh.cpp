@@ -138,6 +138,16 @@ TEST_CASE("Test Cylinder-Brick Initialization")
   REQUIRE(prop.type == PropertyType::MATERIAL);
   REQUIRE(prop.value == "iron");
 
+  // the volume tables map elements to their volume
+  mesh_manager->build_volume_tables();
+  REQUIRE(mesh_manager->element_parent_volume(vol1_elems.front()) == 1);
+  REQUIRE(mesh_manager->element_parent_volume(vol2_elems.front()) == 2);
+
+  // materials are read from the interned volume properties
+  const auto& volume_properties = mesh_manager->volume_properties();
+  REQUIRE(volume_properties.value(PropertyType::MATERIAL, mesh_manager->volume_property_id(1, PropertyType::MATERIAL)).value == "steel");
+  REQUIRE(volume_properties.value(PropertyType::MATERIAL, mesh_manager->volume_property_id(2, PropertyType::MATERIAL)).value == "iron");
+
   for (auto s : mesh_manager->surfaces()) {
     prop = mesh_manager->get_surface_property(s, PropertyType::BOUNDARY_CONDITION);
     std::cout << s << ", " << prop.value << std::endl;
@@ -33,6 +33,14 @@ TEST_CASE("Test MOAB Initialization")
   mesh_manager->create_implicit_complement();
   REQUIRE(mesh_manager->num_volumes() == 5);
 
+  // the topology snapshot is rebuilt to include the new volume
+  REQUIRE(mesh_manager->has_topology());
+  MeshID ipc = mesh_manager->implicit_complement();
+  REQUIRE(mesh_manager->topology().has_volume(ipc));
+  for (auto surface : mesh_manager->get_volume_surfaces(ipc)) {
+    REQUIRE(mesh_manager->topology().surface_sense(surface, ipc) != Sense::UNSET);
+  }
+
   // parse metadata
   mesh_manager->parse_metadata();
 
@@ -51,12 +59,30 @@ TEST_CASE("Test MOAB Initialization")
     REQUIRE(material_exp_results[volume] == prop.value);
   }
 
+  // volumes sharing a material share its interned value
+  const auto& volume_properties = mesh_manager->volume_properties();
+  REQUIRE(volume_properties.values(PropertyType::MATERIAL).size() == 4);
+  for (auto volume : mesh_manager->volumes()) {
+    PropertyID material = mesh_manager->volume_property_id(volume, PropertyType::MATERIAL);
+    REQUIRE(material != PROPERTY_NONE);
+    REQUIRE(volume_properties.value(PropertyType::MATERIAL, material).value == material_exp_results[volume]);
+  }
+  REQUIRE(mesh_manager->volume_property_id(4, PropertyType::MATERIAL) ==
+          mesh_manager->volume_property_id(5, PropertyType::MATERIAL));
+
   std::vector reflecting_surface_ids {2, 3, 14, 15, 17, 18};
   for (auto surface : reflecting_surface_ids) {
     auto prop = mesh_manager->get_surface_property(surface, PropertyType::BOUNDARY_CONDITION);
     REQUIRE(prop.value == "reflecting");
   }
 
+  // boundary checks compare interned IDs rather than strings
+  PropertyID reflecting = mesh_manager->surface_properties().value_id(PropertyType::BOUNDARY_CONDITION, "reflecting");
+  REQUIRE(reflecting != PROPERTY_NONE);
+  for (auto surface : reflecting_surface_ids) {
+    REQUIRE(mesh_manager->surface_property_id(surface, PropertyType::BOUNDARY_CONDITION) == reflecting);
+  }
+
   // none of the volumes in this model should contain volumetric elements
   for (auto volume : mesh_manager->volumes()) {
     REQUIRE(mesh_manager->num_volume_elements(volume) == 0);
@@ -126,6 +152,50 @@ TEMPLATE_TEST_CASE("Test Ray Fire MOAB (all built backends)", "[ray_tracer][moab
   }
 }
 
+TEST_CASE("Test MOAB Volume Segments")
+{
+  std::shared_ptr<XDG> xdg = XDG::create(MeshLibrary::MOAB);
+  const auto& mm = xdg->mesh_manager();
+  mm->load_file("pwr_pincell.h5m");
+  mm->init();
+  xdg->prepare_raytracer();
+
+  // tracks through the center of the pin cell, starting and ending outside
+  // of the model in the implicit complement
+  BoundingBox bbox = mm->global_bounding_box();
+  Position center = bbox.center();
+  Position width = bbox.width();
+  std::vector<Direction> directions {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, Direction {1.0, 1.0, 0.1}.normalize()};
+  MeshID center_volume = xdg->find_volume(center, directions[0]);
+
+  for (const auto& u : directions) {
+    Position start = center - u * width.length();
+    Position end = center + u * width.length();
+    auto segments = xdg->volume_segments(start, end);
+    REQUIRE(segments.size() >= 3);
+
+    // the track starts and ends in the volume containing its end points and
+    // passes through the volume at the center of the model
+    REQUIRE(segments.front().first == xdg->find_volume(start, u));
+    REQUIRE(segments.back().first == xdg->find_volume(end, -u));
+    REQUIRE(std::any_of(segments.begin(), segments.end(),
+                        [&](const auto& segment) { return segment.first == center_volume; }));
+
+    // each segment lies in a different volume than the one before it and
+    // its midpoint is located in the volume of the segment
+    double total = 0.0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+      const auto& [volume, length] = segments[i];
+      REQUIRE(length > 0.0);
+      if (i > 0) REQUIRE(volume != segments[i - 1].first);
+      Position midpoint = start + u * (total + 0.5 * length);
+      REQUIRE(xdg->find_volume(midpoint, u) == volume);
+      total += length;
+    }
+    REQUIRE_THAT(total, Catch::Matchers::WithinAbs((end - start).length(), 1e-8));
+  }
+}
+
 TEST_CASE("MOAB Element Types")
 {
   std::shared_ptr<XDG> xdg = XDG::create(MeshLibrary::MOAB);
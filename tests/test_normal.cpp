@@ -40,4 +40,40 @@ TEST_CASE("Test Get Normal")
   std::vector<MeshID> exclude_primitives {triangle};
   normal = xdg->surface_normal(surface, origin, &exclude_primitives);
   REQUIRE(normal == mm->face_normal(triangle));
-}
\ No newline at end of file
+}
+TEST_CASE("Test Face Plane Cache")
+{
+  std::shared_ptr<MeshManager> mm = std::make_shared<MeshMock>();
+  mm->init();
+  REQUIRE_FALSE(mm->has_face_planes());
+
+  // planes are computed when the trees are built unless disabled
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  TreeOptions options;
+  options.face_planes = false;
+  xdg->prepare_raytracer(options);
+  REQUIRE_FALSE(mm->has_face_planes());
+
+  std::unordered_map<MeshID, FacePlane> expected;
+  for (auto surface : mm->surfaces()) {
+    for (auto face : mm->get_surface_faces(surface)) expected[face] = mm->face_plane(face);
+  }
+
+  xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+  REQUIRE(mm->has_face_planes());
+
+  for (const auto& [face, plane] : expected) {
+    REQUIRE(mm->face_normal(face) == plane.normal);
+    REQUIRE(mm->face_plane(face).offset == plane.offset);
+    // every vertex of the face lies on its plane
+    for (const auto& v : mm->face_vertices(face)) {
+      REQUIRE_THAT(plane.normal.dot(v), Catch::Matchers::WithinAbs(plane.offset, 1e-12));
+    }
+  }
+
+  // the cached normals are used for surface normal queries
+  Position origin {4.0, 0.0, 0.0};
+  auto [nearest_distance, triangle] = xdg->closest(mm->volumes()[0], origin);
+  REQUIRE(xdg->surface_normal(mm->surfaces()[3], origin) == expected.at(triangle).normal);
+}
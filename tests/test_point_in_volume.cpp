@@ -6,6 +6,7 @@
 // xdg includes
 #include "xdg/constants.h"
 #include "xdg/mesh_manager_interface.h"
+#include "xdg/xdg.h"
 #include "util.h"
 #include "mesh_mock.h"
 
@@ -78,3 +79,100 @@ TEMPLATE_TEST_CASE("Point-in-volume on MeshMock", "[piv][mock]",
     REQUIRE(result == false);
   }
 }
+
+TEMPLATE_TEST_CASE("Batched point-in-volume and find volume on MeshMock", "[piv][mock][batch]",
+                   Embree_Raytracer,
+                   GPRT_Raytracer)
+{
+  constexpr auto rt_backend = TestType::value;
+
+  DYNAMIC_SECTION(fmt::format("Backend = {}", rt_backend)) {
+    check_ray_tracer_supported(rt_backend); // skip if backend not enabled at configuration time
+
+    auto mm = std::make_shared<MeshMock>(false);
+    mm->init();
+    auto xdg = std::make_shared<XDG>(mm, rt_backend);
+    xdg->prepare_raytracer();
+    MeshID volume = mm->volumes()[0];
+
+    // alternate points inside and outside of the cube
+    size_t n_points = 500;
+    std::vector<Position> points(n_points);
+    std::vector<Direction> directions(n_points, {1.0, 0.0, 0.0});
+    for (size_t i = 0; i < n_points; ++i) {
+      double x = -1.0 + 5.0 * i / n_points;
+      points[i] = i % 2 == 0 ? Position {x, 0.0, 0.0} : Position {x, 0.0, 100.0};
+    }
+
+    std::vector<PointInVolume> results(n_points);
+    xdg->point_in_volume_batch(volume, n_points, points.data(), nullptr, results.data());
+    for (size_t i = 0; i < n_points; ++i) {
+      REQUIRE(results[i] == (i % 2 == 0 ? INSIDE : OUTSIDE));
+    }
+
+    xdg->point_in_volume_batch(volume, n_points, points.data(), directions.data(), results.data());
+    for (size_t i = 0; i < n_points; ++i) {
+      REQUIRE(results[i] == (i % 2 == 0 ? INSIDE : OUTSIDE));
+    }
+
+    // points outside of all volumes are located in the implicit complement
+    std::vector<MeshID> volumes(n_points);
+    xdg->find_volume_batch(n_points, points.data(), directions.data(), volumes.data());
+    for (size_t i = 0; i < n_points; ++i) {
+      REQUIRE(volumes[i] == (i % 2 == 0 ? volume : mm->implicit_complement()));
+      REQUIRE(volumes[i] == xdg->find_volume(points[i], directions[i]));
+    }
+
+    xdg->find_volume_batch(n_points, points.data(), nullptr, volumes.data());
+    for (size_t i = 0; i < n_points; ++i) {
+      REQUIRE(volumes[i] == (i % 2 == 0 ? volume : mm->implicit_complement()));
+    }
+
+    // without a global surface tree each volume is tested in turn
+    auto xdg_no_global = std::make_shared<XDG>(mm, rt_backend);
+    TreeOptions options;
+    options.global_trees = false;
+    xdg_no_global->prepare_raytracer(options);
+    xdg_no_global->find_volume_batch(n_points, points.data(), directions.data(), volumes.data());
+    for (size_t i = 0; i < n_points; ++i) {
+      REQUIRE(volumes[i] == (i % 2 == 0 ? volume : mm->implicit_complement()));
+    }
+  }
+}
+
+TEMPLATE_TEST_CASE("Find volume using the global surface tree on MeshMock", "[piv][mock]",
+                   Embree_Raytracer,
+                   GPRT_Raytracer)
+{
+  constexpr auto rt_backend = TestType::value;
+
+  DYNAMIC_SECTION(fmt::format("Backend = {}", rt_backend)) {
+    check_ray_tracer_supported(rt_backend); // skip if backend not enabled at configuration time
+
+    auto mm = std::make_shared<MeshMock>(false);
+    mm->init();
+    auto xdg = std::make_shared<XDG>(mm, rt_backend);
+    xdg->prepare_raytracer();
+    REQUIRE(xdg->ray_tracing_interface()->global_surface_tree() != TREE_NONE);
+    MeshID volume = mm->volumes()[0];
+    MeshID ipc = mm->implicit_complement();
+
+    // rays leaving the cube hit a face along its normal
+    REQUIRE(xdg->find_volume({0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}) == volume);
+    REQUIRE(xdg->find_volume({0.0, 0.0, 0.0}, {0.0, -1.0, 0.0}) == volume);
+
+    // rays entering the cube hit a face against its normal
+    REQUIRE(xdg->find_volume({10.0, 0.0, 0.0}, {-1.0, 0.0, 0.0}) == ipc);
+
+    // rays that escape are confirmed by a second ray
+    REQUIRE(xdg->find_volume({10.0, 0.0, 0.0}, {1.0, 0.0, 0.0}) == ipc);
+
+    // oblique rays give the same result
+    REQUIRE(xdg->find_volume({1.0, 1.0, 1.0}, {1.0, 1.0, 1.0}) == volume);
+    REQUIRE(xdg->find_volume({-3.0, 0.0, 0.0}, {1.0, 1.0, 0.0}) == ipc);
+
+    // the hint volume is tested first but does not change the result
+    REQUIRE(xdg->find_volume({0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, volume) == volume);
+    REQUIRE(xdg->find_volume({10.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, volume) == ipc);
+  }
+}
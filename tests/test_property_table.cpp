@@ -0,0 +1,98 @@
+#include <map>
+#include <vector>
+
+// for testing
+#include <catch2/catch_test_macros.hpp>
+
+// xdg includes
+#include "xdg/constants.h"
+#include "xdg/property_table.h"
+
+#include "mesh_mock.h"
+
+using namespace xdg;
+
+TEST_CASE("Property Table Interning")
+{
+  // non-contiguous, unordered entity IDs
+  std::vector<MeshID> volumes {7, 1, 2, 3, 10};
+
+  std::map<std::pair<MeshID, PropertyType>, Property> metadata;
+  metadata[{1, PropertyType::MATERIAL}] = {PropertyType::MATERIAL, "steel"};
+  metadata[{2, PropertyType::MATERIAL}] = {PropertyType::MATERIAL, "water"};
+  metadata[{3, PropertyType::MATERIAL}] = {PropertyType::MATERIAL, "steel"};
+  metadata[{7, PropertyType::MATERIAL}] = VOID_MATERIAL;
+  metadata[{3, PropertyType::TEMPERATURE}] = {PropertyType::TEMPERATURE, "300"};
+  // entities that are not in the table are ignored
+  metadata[{4, PropertyType::MATERIAL}] = {PropertyType::MATERIAL, "lead"};
+
+  PropertyTable table(volumes, metadata);
+  REQUIRE(table.size() == volumes.size());
+
+  // each distinct value is stored once
+  const auto& materials = table.values(PropertyType::MATERIAL);
+  REQUIRE(materials.size() == 3);
+  REQUIRE(table.id(1, PropertyType::MATERIAL) == table.id(3, PropertyType::MATERIAL));
+  REQUIRE(table.id(1, PropertyType::MATERIAL) != table.id(2, PropertyType::MATERIAL));
+  for (auto volume : {1, 2, 3, 7}) {
+    PropertyID id = table.id(volume, PropertyType::MATERIAL);
+    REQUIRE(id != PROPERTY_NONE);
+    REQUIRE(table.value(PropertyType::MATERIAL, id).type == PropertyType::MATERIAL);
+    REQUIRE(table.value(PropertyType::MATERIAL, id).value == metadata.at({volume, PropertyType::MATERIAL}).value);
+  }
+
+  // values are looked up once and compared by ID
+  PropertyID steel = table.value_id(PropertyType::MATERIAL, "steel");
+  REQUIRE(steel == table.id(1, PropertyType::MATERIAL));
+  REQUIRE(table.value_id(PropertyType::MATERIAL, "lead") == PROPERTY_NONE);
+  REQUIRE(table.value_id(PropertyType::DENSITY, "steel") == PROPERTY_NONE);
+
+  // missing properties and entities
+  REQUIRE(table.id(10, PropertyType::MATERIAL) == PROPERTY_NONE);
+  REQUIRE(table.id(1, PropertyType::TEMPERATURE) == PROPERTY_NONE);
+  REQUIRE(table.value(PropertyType::TEMPERATURE, table.id(3, PropertyType::TEMPERATURE)).value == "300");
+  REQUIRE(table.id(4, PropertyType::MATERIAL) == PROPERTY_NONE);
+  REQUIRE(table.id(ID_NONE, PropertyType::BOUNDARY_CONDITION) == PROPERTY_NONE);
+
+  PropertyTable empty;
+  REQUIRE(empty.empty());
+  REQUIRE(empty.id(1, PropertyType::MATERIAL) == PROPERTY_NONE);
+}
+
+// mock mesh with a material on its volume and a boundary condition on one surface
+class MetadataMeshMock : public MeshMock {
+public:
+  void parse_metadata() override {
+    volume_metadata_[{volumes()[0], PropertyType::MATERIAL}] = {PropertyType::MATERIAL, "steel"};
+    surface_metadata_[{surfaces()[0], PropertyType::BOUNDARY_CONDITION}] = {PropertyType::BOUNDARY_CONDITION, "reflecting"};
+    build_property_tables();
+  }
+};
+
+TEST_CASE("Mesh Manager Property Tables")
+{
+  MetadataMeshMock mm;
+  REQUIRE_FALSE(mm.has_property_tables());
+  mm.parse_metadata();
+  REQUIRE(mm.has_property_tables());
+
+  MeshID volume = mm.volumes()[0];
+  PropertyID steel = mm.volume_properties().value_id(PropertyType::MATERIAL, "steel");
+  REQUIRE(steel != PROPERTY_NONE);
+  REQUIRE(mm.volume_property_id(volume, PropertyType::MATERIAL) == steel);
+  REQUIRE(mm.volume_has_property(volume, PropertyType::MATERIAL));
+  REQUIRE_FALSE(mm.volume_has_property(volume, PropertyType::DENSITY));
+
+  // property queries return the interned values
+  const Property& material = mm.get_volume_property(volume, PropertyType::MATERIAL);
+  REQUIRE(&material == &mm.volume_properties().value(PropertyType::MATERIAL, steel));
+  REQUIRE(material.value == "steel");
+
+  PropertyID reflecting = mm.surface_properties().value_id(PropertyType::BOUNDARY_CONDITION, "reflecting");
+  REQUIRE(mm.surface_property_id(mm.surfaces()[0], PropertyType::BOUNDARY_CONDITION) == reflecting);
+  REQUIRE(mm.get_surface_property(mm.surfaces()[0], PropertyType::BOUNDARY_CONDITION).value == "reflecting");
+
+  // surfaces without a boundary condition are transmissive
+  REQUIRE(mm.surface_property_id(mm.surfaces()[1], PropertyType::BOUNDARY_CONDITION) == PROPERTY_NONE);
+  REQUIRE(mm.get_surface_property(mm.surfaces()[1], PropertyType::BOUNDARY_CONDITION).value == "transmission");
+}
@@ -100,6 +100,7 @@ TEST_CASE("Test RTCSurfaceDualRay properties")
     REQUIRE(ray.rf_type == RayFireType::VOLUME);
     REQUIRE(ray.orientation == HitOrientation::EXITING);
     REQUIRE(ray.exclude_primitives == nullptr);
+    REQUIRE(ray.history == nullptr);
   }
 
   SECTION("Setting ray fire type and orientation")
@@ -8,6 +8,7 @@
 // xdg includes
 #include "xdg/constants.h"
 #include "xdg/mesh_manager_interface.h"
+#include "xdg/xdg.h"
 #include "mesh_mock.h"
 #include "util.h"
 
@@ -109,4 +110,191 @@ TEMPLATE_TEST_CASE("Ray Fire on MeshMock (per-backend sections)", "[rayfire][moc
     intersection = rti->ray_fire(volume_tree, origin, direction, INFTY, HitOrientation::EXITING, &exclude_primitives);
     REQUIRE(intersection.second == ID_NONE);
   }
-}
\ No newline at end of file
+}
+#ifdef XDG_ENABLE_EMBREE
+TEST_CASE("Ray Fire on MeshMock with Embree surface options", "[rayfire][mock][embree]")
+{
+  auto mm = std::make_shared<MeshMock>(false);
+  mm->init();
+
+  for (auto mode : {EmbreeSurfaceMode::USER, EmbreeSurfaceMode::TRIANGLE}) {
+  for (bool cache : {true, false}) {
+  for (bool planes : {true, false}) {
+    DYNAMIC_SECTION(fmt::format("Triangle mode = {}, Vertex cache = {}, Plane cache = {}",
+                                mode == EmbreeSurfaceMode::TRIANGLE, cache, planes))
+    {
+      auto rti = std::make_shared<EmbreeRayTracer>();
+      rti->set_surface_mode(mode);
+      rti->set_cache_triangle_vertices(cache);
+      rti->set_cache_face_planes(planes);
+      if (planes) mm->build_face_planes();
+      auto [volume_tree, element_tree] = rti->register_volume(mm, mm->volumes()[0]);
+      rti->init();
+
+      if (cache)
+        REQUIRE(rti->triangle_vertex_cache_size() == 12 * sizeof(std::array<Vertex, 3>));
+      else
+        REQUIRE(rti->triangle_vertex_cache_size() == 0);
+
+      if (planes)
+        REQUIRE(mm->face_plane_cache_size() == 12 * sizeof(FacePlane));
+      else
+        REQUIRE(mm->face_plane_cache_size() == 0);
+
+      Position origin {0.0, 0.0, 0.0};
+      std::vector<std::pair<Direction, double>> expected {{{1.0, 0.0, 0.0}, 5.0}, {{-1.0, 0.0, 0.0}, 2.0},
+                                                          {{0.0, 1.0, 0.0}, 6.0}, {{0.0, -1.0, 0.0}, 3.0},
+                                                          {{0.0, 0.0, 1.0}, 7.0}, {{0.0, 0.0, -1.0}, 4.0}};
+      for (const auto& [direction, distance] : expected) {
+        auto intersection = rti->ray_fire(volume_tree, origin, direction);
+        REQUIRE_THAT(intersection.first, Catch::Matchers::WithinAbs(distance, 1e-6));
+      }
+
+      // entering hits from outside of the cube
+      auto intersection = rti->ray_fire(volume_tree, {-10.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, INFTY, HitOrientation::ENTERING);
+      REQUIRE_THAT(intersection.first, Catch::Matchers::WithinAbs(8.0, 1e-6));
+
+      // hits right at the distance limit are retained
+      intersection = rti->ray_fire(volume_tree, origin, {1.0, 0.0, 0.0}, 5.0);
+      REQUIRE(intersection.second != ID_NONE);
+      intersection = rti->ray_fire(volume_tree, origin, {1.0, 0.0, 0.0}, 4.5);
+      REQUIRE(intersection.second == ID_NONE);
+
+      // a ray toward the center of a face, along the diagonal edge of its triangles
+      intersection = rti->ray_fire(volume_tree, origin, Direction {5.0, 1.5, 1.5}.normalize());
+      REQUIRE(intersection.second != ID_NONE);
+      REQUIRE_THAT(intersection.first, Catch::Matchers::WithinAbs(Direction {5.0, 1.5, 1.5}.length(), 1e-6));
+
+      // excluded primitives are skipped
+      std::vector<MeshID> exclude_primitives;
+      intersection = rti->ray_fire(volume_tree, origin, {1.0, 0.0, 0.0}, INFTY, HitOrientation::EXITING, &exclude_primitives);
+      REQUIRE(exclude_primitives.size() == 1);
+      intersection = rti->ray_fire(volume_tree, origin, {1.0, 0.0, 0.0}, INFTY, HitOrientation::EXITING, &exclude_primitives);
+      REQUIRE(intersection.second == ID_NONE);
+
+      auto [closest_dist, closest_face] = rti->closest(volume_tree, {4.0, 0.0, 0.0});
+      REQUIRE_THAT(closest_dist, Catch::Matchers::WithinAbs(1.0, 1e-6));
+
+      REQUIRE(rti->point_in_volume(volume_tree, origin));
+      REQUIRE(!rti->point_in_volume(volume_tree, {10.0, 0.0, 0.0}));
+
+      double dist;
+      REQUIRE(rti->occluded(volume_tree, origin, {1.0, 0.0, 0.0}, dist));
+      REQUIRE(!rti->occluded(volume_tree, {10.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, dist));
+      REQUIRE(dist == INFTY);
+    }
+  }
+  }
+  }
+}
+#endif
+
+TEMPLATE_TEST_CASE("Batched Ray Fire on MeshMock", "[rayfire][mock][batch]",
+                   Embree_Raytracer,
+                   GPRT_Raytracer)
+{
+  constexpr auto rt_backend = TestType::value;
+  check_ray_tracer_supported(rt_backend); // skip if backend not enabled at configuration time
+
+  DYNAMIC_SECTION(fmt::format("Backend = {}", rt_backend))
+  {
+    auto mm = std::make_shared<MeshMock>(false);
+    mm->init();
+    auto xdg = std::make_shared<XDG>(mm, rt_backend);
+    xdg->prepare_raytracer();
+
+    MeshID volume = mm->volumes()[0];
+    std::vector<Direction> directions {{1.0, 0.0, 0.0}, {-1.0, 0.0, 0.0},
+                                       {0.0, 1.0, 0.0}, {0.0, -1.0, 0.0},
+                                       {0.0, 0.0, 1.0}, {0.0, 0.0, -1.0}};
+    std::vector<double> expected {5.0, 2.0, 6.0, 3.0, 7.0, 4.0};
+
+    // repeat the directions to create a larger batch
+    size_t n_rays = 600;
+    std::vector<MeshID> volumes(n_rays, volume);
+    std::vector<Position> origins(n_rays, {0.0, 0.0, 0.0});
+    std::vector<Direction> ray_directions(n_rays);
+    for (size_t i = 0; i < n_rays; ++i) ray_directions[i] = directions[i % directions.size()];
+
+    std::vector<double> distances(n_rays);
+    std::vector<MeshID> surfaces(n_rays);
+    xdg->ray_fire_batch(n_rays, volumes.data(), origins.data(), ray_directions.data(), nullptr,
+                        distances.data(), surfaces.data());
+
+    for (size_t i = 0; i < n_rays; ++i) {
+      REQUIRE_THAT(distances[i], Catch::Matchers::WithinAbs(expected[i % expected.size()], 1e-6));
+      REQUIRE(surfaces[i] != ID_NONE);
+    }
+
+    // distance limits are applied per ray
+    std::vector<double> dist_limits(n_rays, 4.5);
+    xdg->ray_fire_batch(n_rays, volumes.data(), origins.data(), ray_directions.data(), dist_limits.data(),
+                        distances.data(), surfaces.data());
+    for (size_t i = 0; i < n_rays; ++i) {
+      if (expected[i % expected.size()] < 4.5) {
+        REQUIRE_THAT(distances[i], Catch::Matchers::WithinAbs(expected[i % expected.size()], 1e-6));
+      } else {
+        REQUIRE(surfaces[i] == ID_NONE);
+        REQUIRE(distances[i] == INFTY);
+      }
+    }
+  }
+}
+
+TEMPLATE_TEST_CASE("Ray Fire with Ray History on MeshMock", "[rayfire][mock][history]",
+                   Embree_Raytracer,
+                   GPRT_Raytracer)
+{
+  constexpr auto rt_backend = TestType::value;
+  check_ray_tracer_supported(rt_backend); // skip if backend not enabled at configuration time
+
+  DYNAMIC_SECTION(fmt::format("Backend = {}", rt_backend))
+  {
+    auto mm = std::make_shared<MeshMock>(false);
+    mm->init();
+    auto xdg = std::make_shared<XDG>(mm, rt_backend);
+    xdg->prepare_raytracer();
+
+    MeshID volume = mm->volumes()[0];
+    Position origin {0.0, 0.0, 0.0};
+    Direction direction {1.0, 0.0, 0.0};
+
+    // the hit face is recorded in the history and excluded from the next query
+    RayHistory history;
+    auto intersection = xdg->ray_fire_with_history(volume, origin, direction, INFTY, HitOrientation::EXITING, &history);
+    REQUIRE_THAT(intersection.first, Catch::Matchers::WithinAbs(5.0, 1e-6));
+    REQUIRE(history.size() == 1);
+    MeshID hit_face = history.back();
+    MeshID hit_surface = intersection.second;
+
+    intersection = xdg->ray_fire_with_history(volume, origin, direction, INFTY, HitOrientation::EXITING, &history);
+    REQUIRE(intersection.second == ID_NONE);
+    REQUIRE(history.size() == 1);
+
+    // with the exiting face excluded, the point appears to be outside of the volume
+    REQUIRE(xdg->point_in_volume(volume, origin, &direction));
+    REQUIRE(xdg->point_in_volume(volume, origin, &direction, nullptr));
+    REQUIRE(!xdg->point_in_volume_with_history(volume, origin, &direction, &history));
+
+    // the normal of the last crossed face is used when available
+    Direction normal = xdg->surface_normal_with_history(hit_surface, origin, &history);
+    REQUIRE_THAT(normal.x, Catch::Matchers::WithinAbs(mm->face_normal(hit_face).x, 1e-12));
+    REQUIRE_THAT(normal.x, Catch::Matchers::WithinAbs(1.0, 1e-12));
+
+    // the history is bounded, old crossings are evicted as new ones are added
+    for (size_t i = 0; i < RayHistory::CAPACITY; ++i) history.push_back(1000 + i);
+    REQUIRE(history.size() == RayHistory::CAPACITY);
+    REQUIRE(!history.contains(hit_face));
+    REQUIRE(history[0] == 1000);
+    REQUIRE(history.back() == 1000 + RayHistory::CAPACITY - 1);
+
+    intersection = xdg->ray_fire_with_history(volume, origin, direction, INFTY, HitOrientation::EXITING, &history);
+    REQUIRE_THAT(intersection.first, Catch::Matchers::WithinAbs(5.0, 1e-6));
+    REQUIRE(history.back() == hit_face);
+    REQUIRE(history[0] == 1001);
+
+    history.reset_to_last();
+    REQUIRE(history.size() == 1);
+    REQUIRE(history.back() == hit_face);
+  }
+}
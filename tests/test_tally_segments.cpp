@@ -1,11 +1,14 @@
 // stl includes
 #include <memory>
+#include <random>
 
 // testing includes
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 
+#include "xdg/tet_mesh.h"
+#include "xdg/track_cursor.h"
 #include "xdg/xdg.h"
 
 #include "mesh_mock.h"
@@ -70,3 +73,329 @@ TEST_CASE("Test Walk Elements") {
   REQUIRE(r.y == Catch::Approx(upper_right_corner.y).epsilon(1e-04));
   REQUIRE(r.z == Catch::Approx(upper_right_corner.z).epsilon(1e-04));
 }
+
+TEST_CASE("Test Walk Elements with Flat Tet Mesh") {
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  mm->init();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+
+  Position r {-1.0, -2.0, -3.0};
+  Position end = mm->bounding_box().upper_right();
+  MeshID element = xdg->find_element(r);
+  REQUIRE(element != ID_NONE);
+
+  // walk through the mesh library first
+  REQUIRE(mm->tet_mesh() == nullptr);
+  auto expected = mm->walk_elements(element, r, end);
+  auto expected_next = mm->next_element(element, r, (end - r).normalize());
+  auto expected_exit = mm->walk_elements(element, r, {-1.0, 0.0, 0.0}, 100.0);
+
+  mm->build_tet_mesh();
+  REQUIRE(mm->tet_mesh() != nullptr);
+  REQUIRE(mm->tet_mesh()->num_elements() == 12);
+
+  auto segments = mm->walk_elements(element, r, end);
+  REQUIRE(segments.size() == expected.size());
+  for (size_t i = 0; i < segments.size(); ++i) {
+    REQUIRE(segments[i].first == expected[i].first);
+    REQUIRE_THAT(segments[i].second, Catch::Matchers::WithinAbs(expected[i].second, 1e-12));
+  }
+
+  auto next = mm->next_element(element, r, (end - r).normalize());
+  REQUIRE(next.first == expected_next.first);
+  REQUIRE_THAT(next.second, Catch::Matchers::WithinAbs(expected_next.second, 1e-12));
+
+  // walks leaving the mesh stop at the boundary
+  auto exit = mm->walk_elements(element, r, {-1.0, 0.0, 0.0}, 100.0);
+  REQUIRE(exit.size() == expected_exit.size());
+  double distance = 0.0;
+  for (size_t i = 0; i < exit.size(); ++i) {
+    REQUIRE(exit[i].first == expected_exit[i].first);
+    distance += exit[i].second;
+  }
+  REQUIRE_THAT(distance, Catch::Matchers::WithinAbs(1.0, 1e-12));
+}
+
+TEST_CASE("Test Flat Tet Mesh Walks Match Ray-Triangle Tests") {
+  // reference walks use the per-face ray-triangle tests of the mesh library path
+  std::shared_ptr<MeshMock> reference = std::make_shared<MeshMock>();
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  mm->build_tet_mesh();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+
+  const auto& tet_mesh = mm->tet_mesh();
+  REQUIRE(tet_mesh != nullptr);
+
+  // each plane is stored once: the 12 surface faces are shared with the
+  // boundary element faces and the 18 interior faces by their two elements
+  REQUIRE(tet_mesh->has_face_planes());
+  REQUIRE(mm->face_plane_cache_size() == 30 * sizeof(FacePlane));
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  BoundingBox bbox = mm->bounding_box();
+  for (int n = 0; n < 200; ++n) {
+    Position r {bbox.min_x + unit(rng) * bbox.width()[0],
+                bbox.min_y + unit(rng) * bbox.width()[1],
+                bbox.min_z + unit(rng) * bbox.width()[2]};
+    Direction u = Direction {normal(rng), normal(rng), normal(rng)}.normalize();
+    MeshID element = xdg->find_element(r);
+    REQUIRE(element != ID_NONE);
+
+    auto expected = reference->walk_elements(element, r, u, 100.0);
+    auto segments = mm->walk_elements(element, r, u, 100.0);
+    REQUIRE(segments.size() == expected.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+      REQUIRE(segments[i].first == expected[i].first);
+      REQUIRE_THAT(segments[i].second, Catch::Matchers::WithinAbs(expected[i].second, 1e-12));
+    }
+
+    // the entry face is only used if the ray leaves through no other face
+    auto exit = tet_mesh->exit_face(tet_mesh->element_index(element), r, u);
+    REQUIRE(exit.first != -1);
+    auto exit_skipping_entry = tet_mesh->exit_face(tet_mesh->element_index(element), r, u, (exit.first + 1) % 4);
+    REQUIRE(exit_skipping_entry.first == exit.first);
+    REQUIRE(exit_skipping_entry.second == exit.second);
+  }
+}
+
+TEST_CASE("Test Segment Visitors") {
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+
+  // a track through the mesh (the mock has no implicit complement to fire
+  // rays against, so the global query is kept within the mesh)
+  Position start {-1.5, 0.5, 0.25};
+  Position end {4.5, 1.0, 0.5};
+  MeshID volume = mm->volumes()[0];
+
+  for (bool flat : {false, true}) {
+    if (flat) mm->build_tet_mesh();
+
+    auto expected = xdg->segments(start, end);
+    REQUIRE(expected.size() > 2);
+
+    // segments are visited in the same order as they are collected
+    std::vector<std::pair<MeshID, double>> visited;
+    xdg->segments(start, end, [&](MeshID element, double length) {
+      visited.push_back({element, length});
+      return true;
+    });
+    REQUIRE(visited == expected);
+
+    // the query stops as soon as the visitor returns false
+    visited.clear();
+    xdg->segments(start, end, [&](MeshID element, double length) {
+      visited.push_back({element, length});
+      return visited.size() < 2;
+    });
+    REQUIRE(visited.size() == 2);
+    REQUIRE(visited[1] == expected[1]);
+
+    // a track through the volume from outside of it crosses the 7 units of the mesh along x
+    Position outside_start {-10.0, 0.5, 0.25};
+    Position outside_end {10.0, 1.0, 0.5};
+    Direction u = Direction(outside_end - outside_start).normalize();
+    double total = 0.0;
+    xdg->segments(volume, outside_start, outside_end, [&](MeshID element, double length) {
+      total += length;
+      return true;
+    });
+    REQUIRE_THAT(total, Catch::Matchers::WithinAbs(7.0 / u.x, 1e-6));
+
+    // walks report the distance traveled through the visited elements
+    Position r = start + (end - start) * 0.45;
+    MeshID element = xdg->find_element(r);
+    auto walk = mm->walk_elements(element, r, u, 2.0);
+    std::vector<std::pair<MeshID, double>> walk_visited;
+    double walked = mm->walk_elements(element, r, u, 2.0, [&](MeshID element, double length) {
+      walk_visited.push_back({element, length});
+      return true;
+    });
+    REQUIRE_THAT(walked, Catch::Matchers::WithinAbs(2.0, 1e-12));
+    REQUIRE(walk_visited == walk);
+  }
+}
+
+TEST_CASE("Test Segment Visitors Calling Into XDG") {
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  TreeOptions options;
+  options.lazy = true;
+  xdg->prepare_raytracer(options);
+
+  Position start {-1.5, 0.5, 0.25};
+  Position end {4.5, 1.0, 0.5};
+  MeshID volume = mm->volumes()[0];
+  double track_length = (end - start).length();
+
+  // visitors may make queries that build trees on demand
+  size_t n_visited = 0;
+  xdg->segments(start, end, [&](MeshID element, double length) {
+    double total = 0.0;
+    xdg->volume_segments(volume, start, end, [&](MeshID segment_volume, double segment_length) {
+      REQUIRE(segment_volume == volume);
+      REQUIRE(xdg->find_element(start) != ID_NONE);
+      total += segment_length;
+      return true;
+    });
+    REQUIRE_THAT(total, Catch::Matchers::WithinAbs(track_length, 1e-6));
+    n_visited++;
+    return true;
+  });
+  REQUIRE(n_visited > 2);
+}
+
+TEST_CASE("Test Batched Segments") {
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+
+  // tracks within the mesh (the mock has no implicit complement)
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> unit(0.05, 0.95);
+  BoundingBox bbox = mm->bounding_box();
+  size_t n_tracks = 200;
+  std::vector<Position> starts(n_tracks), ends(n_tracks);
+  for (size_t i = 0; i < n_tracks; ++i) {
+    for (auto p : {&starts[i], &ends[i]}) {
+      *p = {bbox.min_x + unit(rng) * bbox.width()[0],
+            bbox.min_y + unit(rng) * bbox.width()[1],
+            bbox.min_z + unit(rng) * bbox.width()[2]};
+    }
+  }
+
+  auto batch = xdg->segments_batch(n_tracks, starts.data(), ends.data());
+  REQUIRE(batch.offsets.size() == n_tracks + 1);
+  REQUIRE(batch.offsets.front() == 0);
+  REQUIRE(batch.offsets.back() == batch.elements.size());
+  REQUIRE(batch.lengths.size() == batch.elements.size());
+
+  for (size_t i = 0; i < n_tracks; ++i) {
+    auto expected = xdg->segments(starts[i], ends[i]);
+    REQUIRE(batch.offsets[i + 1] - batch.offsets[i] == expected.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+      REQUIRE(batch.elements[batch.offsets[i] + j] == expected[j].first);
+      REQUIRE(batch.lengths[batch.offsets[i] + j] == expected[j].second);
+    }
+  }
+
+  auto empty = xdg->segments_batch(0, nullptr, nullptr);
+  REQUIRE(empty.offsets == std::vector<size_t> {0});
+  REQUIRE(empty.elements.empty());
+}
+
+TEST_CASE("Test Track Cursor") {
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+
+  // a track within the mesh (the mock has no implicit complement)
+  Position start {-1.5, 0.5, 0.25};
+  Position end {4.5, 1.0, 0.5};
+  Direction u = Direction(end - start).normalize();
+  double distance = (end - start).length();
+
+  for (bool flat : {false, true}) {
+    if (flat) mm->build_tet_mesh();
+
+    auto expected = xdg->segments(start, end);
+    REQUIRE(expected.size() > 2);
+
+    TrackCursor cursor(xdg, start, u);
+    REQUIRE(cursor.element() == xdg->find_element(start));
+    REQUIRE(cursor.volume() == mm->volumes()[0]);
+
+    // flying the track in several flights splits the segments at the end of
+    // each flight, but covers the same elements
+    std::vector<std::pair<MeshID, double>> segments;
+    int n_flights = 5;
+    for (int i = 0; i < n_flights; i++) {
+      double moved = cursor.advance(distance / n_flights, [&](MeshID element, double length) {
+        if (!segments.empty() && segments.back().first == element)
+          segments.back().second += length;
+        else
+          segments.push_back({element, length});
+        return true;
+      });
+      REQUIRE_THAT(moved, Catch::Matchers::WithinAbs(distance / n_flights, 1e-12));
+      REQUIRE(cursor.element() == xdg->find_element(cursor.position()));
+    }
+
+    REQUIRE(segments.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+      REQUIRE(segments[i].first == expected[i].first);
+      REQUIRE_THAT(segments[i].second, Catch::Matchers::WithinAbs(expected[i].second, 1e-10));
+    }
+    REQUIRE_THAT((cursor.position() - end).length(), Catch::Matchers::WithinAbs(0.0, 1e-10));
+
+    // turning the track keeps the current element
+    cursor.set_direction({-u.x, -u.y, -u.z});
+    auto back = cursor.advance(distance);
+    REQUIRE(back.size() == expected.size());
+    REQUIRE(back.front().first == expected.back().first);
+    REQUIRE(back.back().first == expected.front().first);
+    REQUIRE_THAT((cursor.position() - start).length(), Catch::Matchers::WithinAbs(0.0, 1e-10));
+
+    // relocating the cursor finds the element containing the new position
+    cursor.set_position(end);
+    REQUIRE(cursor.element() == xdg->find_element(end));
+    REQUIRE(cursor.volume() == mm->volumes()[0]);
+    REQUIRE(cursor.last_face() == ID_NONE);
+  }
+}
+
+TEST_CASE("Test Volume Segments") {
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+  MeshID volume = mm->volumes()[0];
+
+  // a track within the volume has a single segment
+  Position start {-1.5, 0.5, 0.25};
+  Position end {4.5, 1.0, 0.5};
+  auto segments = xdg->volume_segments(start, end);
+  REQUIRE(segments.size() == 1);
+  REQUIRE(segments[0].first == volume);
+  REQUIRE_THAT(segments[0].second, Catch::Matchers::WithinAbs((end - start).length(), 1e-12));
+
+  // the length of each volume segment matches the lengths of its element segments
+  double element_total = 0.0;
+  for (const auto& segment : xdg->segments(start, end)) element_total += segment.second;
+  REQUIRE_THAT(segments[0].second, Catch::Matchers::WithinAbs(element_total, 1e-10));
+
+  // a track leaving the volume ends at the boundary (the mock has no implicit complement)
+  Position outside {10.0, 0.5, 0.25};
+  segments = xdg->volume_segments(start, outside);
+  REQUIRE(segments.size() == 1);
+  REQUIRE(segments[0].first == volume);
+  REQUIRE_THAT(segments[0].second, Catch::Matchers::WithinAbs(6.5, 1e-12));
+
+  // the query stops as soon as the visitor returns false
+  int n_visited = 0;
+  xdg->volume_segments(volume, start, outside, [&](MeshID, double) {
+    n_visited++;
+    return false;
+  });
+  REQUIRE(n_visited == 1);
+
+  // batched tracks match the individual queries
+  std::vector<Position> starts {start, start, {0.0, 0.0, 0.0}, start};
+  std::vector<Position> ends {end, outside, {1.0, -2.0, 3.0}, start};
+  auto batch = xdg->volume_segments_batch(starts.size(), starts.data(), ends.data());
+  REQUIRE(batch.offsets.size() == starts.size() + 1);
+  for (size_t i = 0; i < starts.size(); ++i) {
+    auto expected = xdg->volume_segments(starts[i], ends[i]);
+    REQUIRE(batch.offsets[i + 1] - batch.offsets[i] == expected.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+      REQUIRE(batch.elements[batch.offsets[i] + j] == expected[j].first);
+      REQUIRE(batch.lengths[batch.offsets[i] + j] == expected[j].second);
+    }
+  }
+  // a zero-length track has no segments
+  REQUIRE(batch.offsets[4] == batch.offsets[3]);
+}
@@ -92,4 +92,27 @@ TEST_CASE("Tetrahedron Intersection Unit Test")
   // Test points that are in one tet but not the other
   CHECK(plucker_tet_containment_test(inside_point, v0_2, v1_2, v2_2, v3_2) == false);
   CHECK(plucker_tet_containment_test(inside_point_2, v0, v1, v2, v3) == false);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Tetrahedron Transform Containment Unit Test")
+{
+  Position v0(1.0, 1.0, 1.0);
+  Position v1(2.0, 1.0, 1.0);
+  Position v2(1.0, 2.0, 1.0);
+  Position v3(1.0, 1.0, 2.0);
+  TetTransform transform = tet_transform(v0, v1, v2, v3);
+
+  // the precomputed transform agrees with the direct test on and around the tetrahedron
+  for (double x = 0.8; x <= 2.2; x += 0.1) {
+    for (double y = 0.8; y <= 2.2; y += 0.1) {
+      for (double z = 0.8; z <= 2.2; z += 0.1) {
+        Position p(x, y, z);
+        CHECK(tet_transform_containment_test(p, transform) == plucker_tet_containment_test(p, v0, v1, v2, v3));
+      }
+    }
+  }
+
+  CHECK(tet_transform_containment_test({1.2, 1.2, 1.2}, transform) == true);
+  CHECK(tet_transform_containment_test({1.0, 1.0, 1.5}, transform) == true);
+  CHECK(tet_transform_containment_test({1.3, 1.3, 0.9}, transform) == false);
+}
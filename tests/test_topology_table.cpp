@@ -0,0 +1,59 @@
+#include <utility>
+#include <vector>
+
+// for testing
+#include <catch2/catch_test_macros.hpp>
+
+// xdg includes
+#include "xdg/constants.h"
+#include "xdg/topology_table.h"
+
+#include "mesh_mock.h"
+
+using namespace xdg;
+
+TEST_CASE("Topology Table")
+{
+  // two volumes sharing surface 3, listed out of order
+  std::vector<MeshID> volumes {2, 1};
+  std::vector<std::vector<MeshID>> volume_surfaces {{3, 4}, {1, 2, 3}};
+  std::vector<MeshID> surfaces {4, 3, 2, 1};
+  std::vector<std::pair<MeshID, MeshID>> senses {{2, ID_NONE}, {1, 2}, {1, ID_NONE}, {1, ID_NONE}};
+
+  TopologyTable topology(volumes, volume_surfaces, surfaces, senses);
+  REQUIRE_FALSE(topology.empty());
+
+  for (size_t i = 0; i < surfaces.size(); ++i)
+    REQUIRE(topology.surface_senses(surfaces[i]) == senses[i]);
+  REQUIRE(topology.surface_senses(5) == std::make_pair(ID_NONE, ID_NONE));
+
+  REQUIRE(topology.surface_sense(3, 1) == Sense::FORWARD);
+  REQUIRE(topology.surface_sense(3, 2) == Sense::REVERSE);
+  REQUIRE(topology.surface_sense(4, 1) == Sense::UNSET);
+
+  // surfaces of each volume are kept in the order given
+  REQUIRE(topology.has_volume(1));
+  REQUIRE(topology.volume_surfaces(1) == std::vector<MeshID> {1, 2, 3});
+  REQUIRE(topology.volume_surfaces(2) == std::vector<MeshID> {3, 4});
+  REQUIRE(topology.volume_surface_senses(2) == std::vector<Sense> {Sense::REVERSE, Sense::FORWARD});
+  REQUIRE_FALSE(topology.has_volume(3));
+  REQUIRE(topology.volume_surfaces(3).empty());
+
+  REQUIRE(TopologyTable().empty());
+}
+
+TEST_CASE("Mesh Manager Topology Snapshot")
+{
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  REQUIRE_FALSE(mm->has_topology());
+  mm->build_topology();
+  REQUIRE(mm->has_topology());
+
+  MeshID volume = mm->volumes()[0];
+  REQUIRE(mm->topology().volume_surfaces(volume) == mm->get_volume_surfaces(volume));
+  for (auto surface : mm->surfaces()) {
+    REQUIRE(mm->get_parent_volumes(surface) == mm->surface_senses(surface));
+    REQUIRE(mm->topology().surface_sense(surface, volume) == Sense::FORWARD);
+    REQUIRE(mm->next_volume(volume, surface) == ID_NONE);
+  }
+}
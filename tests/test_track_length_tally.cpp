@@ -0,0 +1,86 @@
+// stl includes
+#include <memory>
+#include <random>
+#include <vector>
+
+// testing includes
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include "xdg/track_length_tally.h"
+#include "xdg/xdg.h"
+
+#include "mesh_mock.h"
+
+using namespace xdg;
+
+TEST_CASE("Test Track Length Tally")
+{
+  std::shared_ptr<MeshMock> mm = std::make_shared<MeshMock>();
+  std::shared_ptr<XDG> xdg = std::make_shared<XDG>(mm);
+  xdg->prepare_raytracer();
+
+  // tracks within the mesh (the mock has no implicit complement to fire
+  // rays against when leaving it)
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  BoundingBox bbox = mm->bounding_box();
+  auto sample = [&]() {
+    return Position {bbox.min_x + (0.05 + 0.9 * unit(rng)) * bbox.width()[0],
+                     bbox.min_y + (0.05 + 0.9 * unit(rng)) * bbox.width()[1],
+                     bbox.min_z + (0.05 + 0.9 * unit(rng)) * bbox.width()[2]};
+  };
+
+  size_t n_tracks = 500;
+  std::vector<Position> starts(n_tracks), ends(n_tracks);
+  std::vector<double> weights(n_tracks);
+  for (size_t i = 0; i < n_tracks; ++i) {
+    starts[i] = sample();
+    ends[i] = sample();
+    weights[i] = 0.5 + unit(rng);
+  }
+
+  // reference scores accumulated from the segments of each track
+  std::vector<double> expected(mm->num_volume_elements(mm->volumes()[0]), 0.0);
+  double total_expected = 0.0;
+  for (size_t i = 0; i < n_tracks; ++i) {
+    for (const auto& [element, length] : xdg->segments(starts[i], ends[i])) {
+      expected[mm->element_index(element)] += weights[i] * length;
+    }
+    total_expected += weights[i] * (ends[i] - starts[i]).length();
+  }
+
+  using Mode = TrackLengthTally::Mode;
+  for (auto [mode, compensated] : {std::pair {Mode::AUTO, false},
+                                   std::pair {Mode::THREAD_LOCAL, false},
+                                   std::pair {Mode::THREAD_LOCAL, true},
+                                   std::pair {Mode::ATOMIC, false}}) {
+    TrackLengthTally tally(xdg, mode, compensated);
+    REQUIRE(tally.num_elements() == 12);
+    REQUIRE(tally.mode() != Mode::AUTO);
+    REQUIRE(tally.compensated() == compensated);
+
+    // score in two batches
+    tally.score(n_tracks / 2, starts.data(), ends.data(), weights.data());
+    tally.score(n_tracks - n_tracks / 2, starts.data() + n_tracks / 2, ends.data() + n_tracks / 2, weights.data() + n_tracks / 2);
+
+    auto results = tally.results();
+    REQUIRE(results.size() == expected.size());
+    double total = 0.0;
+    for (size_t j = 0; j < results.size(); ++j) {
+      REQUIRE_THAT(results[j], Catch::Matchers::WithinRel(expected[j], 1e-12));
+      REQUIRE(tally.result(mm->element_id(j)) == results[j]);
+      total += results[j];
+    }
+    REQUIRE_THAT(total, Catch::Matchers::WithinRel(total_expected, 1e-9));
+
+    tally.reset();
+    for (double result : tally.results()) REQUIRE(result == 0.0);
+
+    // tracks have unit weight if no weights are given
+    tally.score(1, starts.data(), ends.data());
+    double track_total = 0.0;
+    for (double result : tally.results()) track_total += result;
+    REQUIRE_THAT(track_total, Catch::Matchers::WithinAbs((ends[0] - starts[0]).length(), 1e-9));
+  }
+}
@@ -0,0 +1,160 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+// for testing
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+// xdg includes
+#include "xdg/constants.h"
+#include "xdg/tree_cache.h"
+#include "xdg/xdg.h"
+#include "mesh_mock.h"
+#include "util.h"
+
+using namespace xdg;
+using namespace xdg::test;
+
+TEST_CASE("Tree Cache Round Trip", "[tree_cache][mock]")
+{
+  auto mm = std::make_shared<MeshMock>();
+  mm->init();
+
+  const std::string cache_file = "tree_cache_round_trip.xdgtree";
+  auto cache = TreeCache::from_mesh(*mm, 42);
+  REQUIRE(cache->key() == 42);
+  REQUIRE(cache->num_surfaces() == mm->surfaces().size());
+  REQUIRE(cache->num_volumes() == mm->volumes().size());
+  cache->write(cache_file);
+
+  // a cache with a different key is not used
+  REQUIRE(TreeCache::open(cache_file, 43) == nullptr);
+  REQUIRE(TreeCache::open("missing_tree_cache.xdgtree", 42) == nullptr);
+
+  auto loaded = TreeCache::open(cache_file, 42);
+  REQUIRE(loaded != nullptr);
+  REQUIRE(loaded->num_surfaces() == mm->surfaces().size());
+  for (auto surface : mm->surfaces()) {
+    REQUIRE(loaded->contains_surface(surface));
+    auto faces = loaded->surface_faces(surface);
+    REQUIRE(std::vector<MeshID>(faces.begin(), faces.end()) == mm->get_surface_faces(surface));
+    for (size_t i = 0; i < faces.size(); ++i) {
+      auto expected = mm->face_vertices(faces[i]);
+      auto vertices = loaded->face_vertices(surface, i);
+      for (int j = 0; j < 3; ++j) {
+        REQUIRE(vertices[j].x == expected[j].x);
+        REQUIRE(vertices[j].y == expected[j].y);
+        REQUIRE(vertices[j].z == expected[j].z);
+      }
+    }
+  }
+  for (auto volume : mm->volumes()) {
+    REQUIRE(loaded->contains_volume(volume));
+    auto elements = loaded->volume_elements(volume);
+    REQUIRE(std::vector<MeshID>(elements.begin(), elements.end()) == mm->get_volume_elements(volume));
+  }
+
+  // the cache only matches a mesh with the same faces and elements
+  REQUIRE(loaded->matches(*mm));
+  auto surface_mesh = std::make_shared<MeshMock>(false);
+  surface_mesh->init();
+  REQUIRE_FALSE(loaded->matches(*surface_mesh));
+
+  // views point into the cache image rather than into copies of it
+  MeshID surface = mm->surfaces()[0];
+  REQUIRE(loaded->surface_faces(surface).data == loaded->surface_faces(surface).data);
+
+  // a file that isn't a cache is ignored
+  {
+    std::ofstream bad(cache_file, std::ios::binary | std::ios::trunc);
+    bad << std::string(128, 'x');
+  }
+  REQUIRE(TreeCache::open(cache_file, 42) == nullptr);
+
+  std::remove(cache_file.c_str());
+}
+
+TEMPLATE_TEST_CASE("Prepare Ray Tracer with a Tree Cache", "[tree_cache][mock]",
+                   Embree_Raytracer,
+                   GPRT_Raytracer)
+{
+  constexpr auto rt_backend = TestType::value;
+  check_ray_tracer_supported(rt_backend); // skip if backend not enabled at configuration time
+
+  DYNAMIC_SECTION(fmt::format("Backend = {}", rt_backend))
+  {
+    // the mock has no mesh file, any file will do to key the cache
+    const std::string mesh_file = "tree_cache_mesh.txt";
+    const std::string cache_file = "tree_cache_prepare.xdgtree";
+    {
+      std::ofstream mesh(mesh_file);
+      mesh << "mock mesh";
+    }
+    std::remove(cache_file.c_str());
+
+    TreeOptions options;
+    options.cache_file = cache_file;
+    options.mesh_file = mesh_file;
+
+    // prepares the ray tracer and returns the key of the cache it used
+    auto prepare = [&](const TreeOptions& tree_options) {
+      auto mm = std::make_shared<MeshMock>();
+      mm->init();
+      auto xdg = std::make_shared<XDG>(mm, rt_backend);
+      xdg->prepare_raytracer(tree_options);
+
+      const auto& cache = xdg->ray_tracing_interface()->tree_cache();
+      REQUIRE(cache != nullptr);
+
+      MeshID volume = mm->volumes()[0];
+      auto hit = xdg->ray_fire(volume, {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0});
+      REQUIRE_THAT(hit.first, Catch::Matchers::WithinAbs(5.0, 1e-6));
+      REQUIRE(xdg->point_in_volume(volume, {0.0, 0.0, 0.0}));
+      REQUIRE(xdg->find_element(volume, {0.0, 0.0, 0.0}) != ID_NONE);
+      return cache->key();
+    };
+
+    // the first preparation creates the cache, the second reads it
+    uint64_t key = prepare(options);
+    REQUIRE(TreeCache::open(cache_file, key) != nullptr);
+    REQUIRE(prepare(options) == key);
+
+    // different build parameters use a different cache
+    TreeOptions no_planes = options;
+    no_planes.face_planes = false;
+    uint64_t no_planes_key = prepare(no_planes);
+    REQUIRE(no_planes_key != key);
+    REQUIRE(TreeCache::open(cache_file, key) == nullptr);
+    REQUIRE(prepare(options) == key);
+
+    // a cache with a matching key for another mesh is rebuilt
+    {
+      auto surface_mesh = std::make_shared<MeshMock>(false);
+      surface_mesh->init();
+      TreeCache::from_mesh(*surface_mesh, key)->write(cache_file);
+    }
+    REQUIRE(prepare(options) == key);
+    auto rebuilt = TreeCache::open(cache_file, key);
+    REQUIRE(rebuilt != nullptr);
+    REQUIRE(rebuilt->volume_elements(0).size() == 12);
+
+    // a change to the mesh file invalidates the cache
+    {
+      std::ofstream mesh(mesh_file);
+      mesh << "modified mock mesh";
+    }
+    uint64_t new_key = prepare(options);
+    REQUIRE(new_key != key);
+    REQUIRE(TreeCache::open(cache_file, key) == nullptr);
+    REQUIRE(TreeCache::open(cache_file, new_key) != nullptr);
+
+    // the key depends on the mesh file and on the build parameters
+    REQUIRE(TreeCache::compute_key(mesh_file, MeshLibrary::MOCK, 1) == TreeCache::compute_key(mesh_file, MeshLibrary::MOCK, 1));
+    REQUIRE(TreeCache::compute_key(mesh_file, MeshLibrary::MOCK, 1) != TreeCache::compute_key(mesh_file, MeshLibrary::MOCK, 2));
+
+    std::remove(cache_file.c_str());
+    std::remove(mesh_file.c_str());
+  }
+}
@@ -1,5 +1,6 @@
 #include <cmath>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <catch2/catch_template_test_macros.hpp>
 #include <catch2/catch_test_macros.hpp>
@@ -9,6 +10,7 @@
 #include "xdg/mesh_managers.h"
 #include "xdg/ray_tracers.h"
 #include "xdg/xdg.h"
+#include "mesh_mock.h"
 #include "util.h"
 
 using namespace xdg;
@@ -160,3 +162,123 @@ TEMPLATE_PRODUCT_TEST_CASE("XDG Query API", "[xdg][queries][rayfire][point_in_vo
     REQUIRE_THAT(hit.first, Catch::Matchers::WithinAbs(5.0, 1e-6));
   }
 }
+
+TEMPLATE_TEST_CASE("XDG Prepare Ray Tracer on MeshMock", "[xdg][prepare][mock]",
+                   Embree_Raytracer,
+                   GPRT_Raytracer)
+{
+  constexpr auto rt_backend = TestType::value;
+  check_ray_tracer_supported(rt_backend); // skip if backend not enabled at configuration time
+
+  DYNAMIC_SECTION(fmt::format("Backend = {}", rt_backend))
+  {
+    auto mm = std::make_shared<MeshMock>();
+    mm->init();
+    auto xdg = std::make_shared<XDG>(mm, rt_backend);
+    xdg->prepare_raytracer();
+
+    // one surface and one element tree for the volume, plus the global trees
+    const auto& rti = xdg->ray_tracing_interface();
+    REQUIRE(rti->num_registered_surface_trees() == 2);
+    REQUIRE(rti->num_registered_element_trees() == 2);
+
+    MeshID volume = mm->volumes()[0];
+    auto hit = xdg->ray_fire(volume, {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0});
+    REQUIRE_THAT(hit.first, Catch::Matchers::WithinAbs(5.0, 1e-6));
+    REQUIRE(xdg->point_in_volume(volume, {0.0, 0.0, 0.0}));
+    REQUIRE(xdg->find_element({0.0, 0.0, 0.0}) != ID_NONE);
+    REQUIRE(xdg->find_element(volume, {0.0, 0.0, 0.0}) != ID_NONE);
+
+    const auto& timings = xdg->prepare_timings();
+    REQUIRE(timings.volume_trees >= 0.0);
+    REQUIRE(timings.global_trees >= 0.0);
+    REQUIRE(timings.init >= 0.0);
+    REQUIRE(timings.total >= timings.cache + timings.volume_trees + timings.global_trees + timings.init);
+  }
+}
+
+TEMPLATE_TEST_CASE("XDG Lazy Tree Construction on MeshMock", "[xdg][prepare][lazy][mock]",
+                   Embree_Raytracer,
+                   GPRT_Raytracer)
+{
+  constexpr auto rt_backend = TestType::value;
+  check_ray_tracer_supported(rt_backend); // skip if backend not enabled at configuration time
+
+  DYNAMIC_SECTION(fmt::format("Backend = {}", rt_backend))
+  {
+    auto mm = std::make_shared<MeshMock>();
+    mm->init();
+    MeshID volume = mm->volumes()[0];
+
+    SECTION("Requested structures only") {
+      auto xdg = std::make_shared<XDG>(mm, rt_backend);
+      TreeOptions options;
+      options.element_trees = false;
+      xdg->prepare_raytracer(options);
+
+      // the volume surface tree and the global surface tree
+      const auto& rti = xdg->ray_tracing_interface();
+      REQUIRE(rti->num_registered_surface_trees() == 2);
+      REQUIRE(rti->num_registered_element_trees() == 0);
+      REQUIRE(xdg->point_in_volume(volume, {0.0, 0.0, 0.0}));
+    }
+
+    SECTION("Trees built on first use") {
+      auto xdg = std::make_shared<XDG>(mm, rt_backend);
+      TreeOptions options;
+      options.lazy = true;
+      xdg->prepare_raytracer(options);
+
+      const auto& rti = xdg->ray_tracing_interface();
+      REQUIRE(rti->num_registered_trees() == 0);
+
+      auto hit = xdg->ray_fire(volume, {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0});
+      REQUIRE_THAT(hit.first, Catch::Matchers::WithinAbs(5.0, 1e-6));
+      REQUIRE(rti->num_registered_surface_trees() == 1);
+      REQUIRE(rti->num_registered_element_trees() == 0);
+
+      // subsequent queries reuse the tree
+      REQUIRE(xdg->point_in_volume(volume, {0.0, 0.0, 0.0}));
+      REQUIRE(rti->num_registered_surface_trees() == 1);
+
+      REQUIRE(xdg->find_element(volume, {0.0, 0.0, 0.0}) != ID_NONE);
+      REQUIRE(rti->num_registered_element_trees() == 1);
+
+      // the global element tree is assembled from the existing element trees
+      REQUIRE(xdg->find_element({0.0, 0.0, 0.0}) != ID_NONE);
+      REQUIRE(rti->num_registered_element_trees() == 2);
+    }
+
+    // only Embree supports concurrent queries (and element trees)
+    if constexpr (rt_backend == RTLibrary::EMBREE) {
+      SECTION("Concurrent first use") {
+        auto xdg = std::make_shared<XDG>(mm, rt_backend);
+        TreeOptions options;
+        options.lazy = true;
+        xdg->prepare_raytracer(options);
+
+        const int n_queries = 16;
+        std::vector<double> distances(n_queries);
+        std::vector<MeshID> elements(n_queries);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < n_queries; ++i) {
+          threads.emplace_back([&, i]() {
+            distances[i] = xdg->ray_fire(volume, {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}).first;
+            elements[i] = xdg->find_element({0.0, 0.0, 0.0});
+          });
+        }
+        for (auto& thread : threads) thread.join();
+
+        // a single builder creates each tree
+        const auto& rti = xdg->ray_tracing_interface();
+        REQUIRE(rti->num_registered_surface_trees() == 1);
+        REQUIRE(rti->num_registered_element_trees() == 2);
+        for (int i = 0; i < n_queries; ++i) {
+          REQUIRE_THAT(distances[i], Catch::Matchers::WithinAbs(5.0, 1e-6));
+          REQUIRE(elements[i] == elements[0]);
+          REQUIRE(elements[i] != ID_NONE);
+        }
+      }
+    }
+  }
+}
@@ -94,6 +94,7 @@ mm->load_file(args.get<std::string>("filename"));
 mm->init();
 mm->parse_metadata();
 xdg->prepare_raytracer();
+xdg->prepare_timings().write();
 
 sim_data.xdg_ = xdg;
 
@@ -19,10 +19,31 @@ struct SimulationData {
   std::unordered_map<MeshID, double> cell_tracks;
 };
 
+// PropertyIDs of the surface boundary conditions handled by the simulation,
+// looked up once so that crossing a surface compares integers
+struct BoundaryConditionIDs {
+  BoundaryConditionIDs() = default;
+  BoundaryConditionIDs(const MeshManager& mesh_manager) {
+    const auto& surface_properties = mesh_manager.surface_properties();
+    reflecting_ = surface_properties.value_id(PropertyType::BOUNDARY_CONDITION, "reflecting");
+    reflective_ = surface_properties.value_id(PropertyType::BOUNDARY_CONDITION, "reflective");
+    vacuum_ = surface_properties.value_id(PropertyType::BOUNDARY_CONDITION, "vacuum");
+  }
+
+  // surfaces without a boundary condition are PROPERTY_NONE, as are values
+  // missing from the model, so neither matches
+  bool reflecting(PropertyID id) const { return id != PROPERTY_NONE && (id == reflecting_ || id == reflective_); }
+  bool vacuum(PropertyID id) const { return id != PROPERTY_NONE && id == vacuum_; }
+
+  PropertyID reflecting_ {PROPERTY_NONE};
+  PropertyID reflective_ {PROPERTY_NONE};
+  PropertyID vacuum_ {PROPERTY_NONE};
+};
+
 struct Particle {
 
-Particle(std::shared_ptr<XDG> xdg, uint32_t id, uint32_t max_events, bool verbose=true, bool ipc_graveyard=false)
-: verbose_(verbose), xdg_(xdg), id_(id), max_events_(max_events), ipc_graveyard_(ipc_graveyard) {}
+Particle(std::shared_ptr<XDG> xdg, const BoundaryConditionIDs& boundary_conditions, uint32_t id, uint32_t max_events, bool verbose=true, bool ipc_graveyard=false)
+: verbose_(verbose), xdg_(xdg), boundary_conditions_(boundary_conditions), id_(id), max_events_(max_events), ipc_graveyard_(ipc_graveyard) {}
 
 template<typename... Params>
 void log (const std::string& msg, const Params&... fmt_args) {
@@ -40,7 +61,7 @@ void initialize() {
 }
 
 void surf_dist() {
-  surface_intersection_ = xdg_->ray_fire(volume_, r_, u_, INFTY, HitOrientation::EXITING, &history_);
+  surface_intersection_ = xdg_->ray_fire_with_history(volume_, r_, u_, INFTY, HitOrientation::EXITING, &history_);
   if (surface_intersection_.first == 0.0) {
     fatal_error("Particle {} stuck at position ({}, {}, {}) on surfacce {}", id_, r_.x, r_.y, r_.z, surface_intersection_.second);
     alive_ = false;
@@ -84,13 +105,13 @@ void cross_surface()
 {
   n_events_++;
   log("Event {} for particle {}", n_events_, id_);
-  auto boundary_condition = xdg_->mesh_manager()->get_surface_property(surface_intersection_.second, PropertyType::BOUNDARY_CONDITION);
+  PropertyID boundary_condition = xdg_->mesh_manager()->surface_property_id(surface_intersection_.second, PropertyType::BOUNDARY_CONDITION);
   // check for the surface boundary condition
-  if (boundary_condition.value == "reflecting" || boundary_condition.value == "reflective") {
+  if (boundary_conditions_.reflecting(boundary_condition)) {
     log("Particle {} reflects off surface {}", id_, surface_intersection_.second);
     log("Direction before reflection: ({}, {}, {})", u_.x, u_.y, u_.z);
 
-    Direction normal = xdg_->surface_normal(surface_intersection_.second, r_, &history_);
+    Direction normal = xdg_->surface_normal_with_history(surface_intersection_.second, r_, &history_);
     log("Normal to surface: ({}, {}, {})", normal.x, normal.y, normal.z);
 
     double proj = dot(normal, u_);
@@ -102,9 +123,9 @@ void cross_surface()
     // reset to last intersection
     if (history_.size() > 0) {
       log("Resetting particle history to last intersection");
-      history_ = {history_.back()};
+      history_.reset_to_last();
     }
-  } else if (boundary_condition.value == "vacuum") {
+  } else if (boundary_conditions_.vacuum(boundary_condition)) {
     log("Particle {} encounters vacuum boundary at surface {}", id_, surface_intersection_.second);
     alive_ = false;
   } else {
@@ -121,6 +142,7 @@ void cross_surface()
 // Data Members
 bool verbose_ {true};
 std::shared_ptr<XDG> xdg_;
+BoundaryConditionIDs boundary_conditions_;
 uint32_t id_ {0};
 int32_t max_events_ {1000};
 bool ipc_graveyard_ {false};
@@ -128,7 +150,7 @@ bool ipc_graveyard_ {false};
 Position r_;
 Direction u_;
 MeshID volume_ {ID_NONE};
-std::vector<MeshID> history_ {};
+RayHistory history_ {};
 std::pair<double, MeshID> surface_intersection_ {INFTY, ID_NONE};
 double collision_distance_ {INFTY};
 int32_t n_events_ {0};
@@ -138,8 +160,9 @@ bool alive_ {true};
 void transport_particles(SimulationData& sim_data) {
   // Problem Setup
   srand48(42);
+  BoundaryConditionIDs boundary_conditions(*sim_data.xdg_->mesh_manager());
   for (uint32_t i = 0; i < sim_data.n_particles_; i++) {
-    Particle p {sim_data.xdg_, i, sim_data.max_events_, sim_data.verbose_particles_, sim_data.implicit_complement_is_graveyard_};
+    Particle p {sim_data.xdg_, boundary_conditions, i, sim_data.max_events_, sim_data.verbose_particles_, sim_data.implicit_complement_is_graveyard_};
     p.initialize();
     while (p.alive_) {
       p.surf_dist();
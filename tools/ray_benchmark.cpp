@@ -13,6 +13,7 @@
 #include "xdg/config.h"
 #include "xdg/constants.h"
 #include "xdg/error.h"
+#include "xdg/ray_tracers.h"
 #include "xdg/timer.h"
 #include "xdg/vec3da.h"
 #include "xdg/xdg.h"
@@ -63,6 +64,11 @@ int main(int argc, char** argv)
     .help("Ray tracing library to use. Currently implemented: EMBREE")
     .default_value("EMBREE");
 
+  args.add_argument("--embree-triangles")
+    .default_value(false)
+    .implicit_value(true)
+    .help("Use native Embree triangle geometries with double precision hit refinement (EMBREE only)");
+
   args.add_argument("-l", "--list")
     .default_value(false)
     .implicit_value(true)
@@ -118,6 +124,7 @@ int main(int argc, char** argv)
   const std::uint32_t seed = args.get<std::uint32_t>("--seed");
   const double source_radius = args.get<double>("--source-radius");
   const std::string output_format = args.get<std::string>("--format");
+  const bool embree_triangles = args.get<bool>("--embree-triangles");
 
   Timer wall_timer;
   Timer setup_timer;
@@ -129,6 +136,15 @@ int main(int argc, char** argv)
   // XDG setup and ray tracer initialisation
   setup_timer.start();
   std::shared_ptr<XDG> xdg = XDG::create(mesh_lib, rt_lib);
+  if (embree_triangles) {
+#ifdef XDG_ENABLE_EMBREE
+    auto embree_rti = std::dynamic_pointer_cast<EmbreeRayTracer>(xdg->ray_tracing_interface());
+    if (!embree_rti) fatal_error("--embree-triangles requires the EMBREE ray tracing library");
+    embree_rti->set_surface_mode(EmbreeSurfaceMode::TRIANGLE);
+#else
+    fatal_error("--embree-triangles requires XDG to be built with Embree support");
+#endif
+  }
   const auto& mesh_manager = xdg->mesh_manager();
   mesh_manager->load_file(model_filename);
   mesh_manager->init();
@@ -173,7 +189,7 @@ int main(int argc, char** argv)
 
   if (rt_lib == RTLibrary::EMBREE) {
     rt_label += " (" + std::to_string(XDGConfig::config().n_threads())
-             + " CPU threads)";
+             + " CPU threads" + (embree_triangles ? ", native triangles" : "") + ")";
   }
 
   const auto num_faces = mesh_manager->num_volume_faces(volume);
@@ -236,6 +252,7 @@ int main(int argc, char** argv)
     "model",
     "mesh_library",
     "rt_library",
+    "embree_triangles",
     "volume",
     "num_faces",
     "num_rays",
@@ -261,6 +278,7 @@ int main(int argc, char** argv)
     model_name,
     mesh_str,
     rt_str,
+    fmt::format("{}", embree_triangles),
     fmt::format("{}", volume),
     fmt::format("{}", num_faces),
     fmt::format("{}", num_rays),